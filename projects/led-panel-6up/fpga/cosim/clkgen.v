@@ -0,0 +1,49 @@
+//=============================================================================================
+// SparkFun / Adafruit 32x32 LED Panel Driver
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+// 
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+// Behavioural model of the clkgen DCM core for co-simulation. The outputs free run at the
+// frequencies the core is configured for and CLK_IN1 is ignored.
+
+`timescale 1ns / 1ps
+
+module clkgen
+(
+	input	wire			CLK_IN1,			// 50MHz clock in
+	output	reg				CLK_OUT1,			// 100MHz
+	output	reg				CLK_OUT2,			// 50MHz
+	output	reg				CLK_OUT3,			// 25MHz
+	output	reg				CLK_OUT4			// 10MHz
+);
+
+initial
+begin
+	CLK_OUT1 = 0;
+	CLK_OUT2 = 0;
+	CLK_OUT3 = 0;
+	CLK_OUT4 = 0;
+end
+
+always #5  CLK_OUT1 = ~CLK_OUT1;
+always #10 CLK_OUT2 = ~CLK_OUT2;
+always #20 CLK_OUT3 = ~CLK_OUT3;
+always #50 CLK_OUT4 = ~CLK_OUT4;
+
+endmodule
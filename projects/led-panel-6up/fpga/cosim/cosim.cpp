@@ -0,0 +1,581 @@
+//=============================================================================================
+// SparkFun / Adafruit 32x32 LED Panel Driver
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+// 
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+// Co-simulation of the 6-up bitstream driven by the real upload code.
+//
+// The RTL is compiled with Verilator together with behavioural models of the clkgen and
+// dpram8192x12 cores. This file replaces the software model in fpgasim.cpp, so fpga.cpp,
+// pipeline.cpp and the delta encoder run unchanged and every Read16 / Write16 becomes a
+// GPMC cycle driven onto the RTL's pins by a model of the AM335x asynchronous multiplexed
+// bus. Time the software spends between bus accesses, measured on the host, passes as idle
+// bus time, so the status polling in pipeline.cpp sees the display refresh move on.
+//
+// A model of the panel shift registers watches the matrix outputs and rebuilds the image
+// from the bit planes it latches, which is compared with the last frame uploaded.
+//
+// Reports, per frame: GPMC cycles and bus time for the upload, and the time from the buffer
+// select write to the matrix controller switching buffers. Overall: the BCM refresh rate
+// and the fraction of the time the display is unblanked.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <vector>
+
+using namespace std;
+
+#include "verilated.h"
+#include "Vbeagle01.h"
+#include "Vbeagle01___024root.h"
+
+#include "globals.h"
+#include "fpga.h"
+#include "fpgasim.h"
+#include "frameloop.h"
+#include "pipeline.h"
+#include "pattern.h"
+#include "tiles.h"
+#include "perlin.h"
+
+// simulation time is in picoseconds
+#define PS_PER_NS 1000LL
+
+// GPMC functional clock, bus timings below are in cycles of it
+#define FCLK_PS (10 * PS_PER_NS)
+
+// bus timings, the same as the led-panel-v01 testbench's gpmc_async_host_model
+#define CS_ON_TIME              0
+#define CS_RD_OFF_TIME         11
+#define CS_WR_OFF_TIME          6
+#define ADV_ON_TIME             0
+#define ADV_RD_OFF_TIME         1
+#define ADV_WR_OFF_TIME         1
+#define OE_ON_TIME              2
+#define OE_OFF_TIME            12
+#define WE_ON_TIME              3
+#define WE_OFF_TIME             6
+#define RD_CYCLE_TIME          12
+#define RD_ACCESS_TIME         11
+#define WR_CYCLE_TIME           7
+#define WR_DATA_ON_ADMUX_BUS    2
+#define CYCLE_2_CYCLE_DELAY     1
+
+// longest idle gap passed to the simulation between two bus accesses
+#define MAX_IDLE_PS (1000000LL * PS_PER_NS)
+
+// columns shifted per row and bit plane, two chains of 96
+#define SHIFT_LENGTH 192
+
+// levels the pattern draws into
+uint16_t gLevels[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+// linear light, for patterns set to draw it
+uint16_t gLinear[3][DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+// palette indices, for patterns set to draw them
+uint8_t gIndices[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+uint16_t gPalette[PALETTE_SIZE];
+int32_t gPaletteRotate = 0;
+
+// simulation
+static VerilatedContext *gContext = NULL;
+static Vbeagle01 *gTop = NULL;
+
+// host time when the previous bus access finished
+static int64_t gHostMark = 0;
+
+// bus counters
+static FpgaSimCounts gCounts;
+static uint64_t gBusCycles = 0;
+
+// buffer select write not yet followed by a swap, -1 if none
+static int64_t gSelectTime = -1;
+
+// swaps and their latency
+static uint64_t gFlips = 0;
+static int64_t gFlipSum = 0;
+static int64_t gFlipMax = 0;
+static uint8_t gCurrent = 0;
+
+// matrix outputs last seen
+static uint8_t gSclk = 0;
+static uint8_t gLatch = 0;
+static uint8_t gBlank = 1;
+
+// latch pulses and unblanked time
+static uint64_t gLatches = 0;
+static int64_t gUnblanked = 0;
+static int64_t gBlankEdge = 0;
+
+// panel shift registers and the image rebuilt from what they latch
+static uint8_t gShift[SHIFT_LENGTH];
+static int32_t gShiftCount = 0;
+static int32_t gShiftPlane = 0;
+static uint16_t gPanel[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+static int64_t Now (void);
+static int64_t HostNow (void);
+static void Run (int64_t until);
+static void Monitor (void);
+static void Idle (void);
+static void BusWrite (uint16_t address, uint16_t data);
+static uint16_t BusRead (uint16_t address);
+static void Latch (void);
+static void Tick (void);
+
+
+//---------------------------------------------------------------------------------------------
+// run the co-simulation
+//
+
+int main (int argc, char *argv[])
+{
+    int32_t frames = 8;
+    int32_t fps = 50;
+    int32_t frame, row, col, mismatches;
+    int64_t period, start, upload;
+    uint64_t cycles, latchStart;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "n:f:")) != -1) {
+        switch (opt) {
+            case 'n': frames = atoi (optarg); break;
+            case 'f': fps = atoi (optarg); break;
+            default: frames = 0; break;
+        }
+    }
+
+    if ((frames <= 0) || (fps <= 0)) {
+        fprintf (stderr, "usage: %s [-n frames] [-f fps]\n", argv[0]);
+        return -1;
+    }
+
+    period = 1000000000LL * PS_PER_NS / fps;
+
+    gContext = new VerilatedContext;
+    gTop = new Vbeagle01 (gContext);
+
+    // idle bus and reset, the pushbutton and switches are unused and stay zero
+    gTop->rst_n = 0;
+    gTop->clk50_in = 0;
+    gTop->gpmc_clk = 0;
+    gTop->gpmc_csn = 1;
+    gTop->gpmc_advn = 0;
+    gTop->gpmc_oen = 1;
+    gTop->gpmc_wen = 1;
+    gTop->gpmc_ben = 3;
+    gTop->gpmc_ad = 0;
+    Run (1000 * PS_PER_NS);
+    gTop->rst_n = 1;
+    Run (2000 * PS_PER_NS);
+
+    // the same start up as the run programs
+    FpgaOpen (FPGA_ACCESS_SIM);
+    memset (gLevels, 0, sizeof (gLevels));
+    WriteLevels ();
+
+    Perlin *pattern = new Perlin (DISPLAY_WIDTH, DISPLAY_HEIGHT, 2, 6.0/64.0, 1.0/64.0,
+        256.0, 0.005);
+    pattern->setNumeric (PERLIN_Q8_8);
+    pattern->init ();
+
+    printf ("frame,bus_writes,bus_reads,bus_cycles,upload_usec,swap_usec\n");
+
+    start = Now ();
+    latchStart = gLatches;
+    gUnblanked = 0;
+    gBlankEdge = start;
+
+    for (frame = 0; frame < frames; frame++) {
+        FpgaSimCounts before = gCounts;
+        uint64_t flipsBefore = gFlips;
+        int64_t flipSumBefore = gFlipSum;
+
+        pattern->next ();
+
+        cycles = gBusCycles;
+        gHostMark = HostNow ();
+        upload = Now ();
+        WriteLevels ();
+        upload = Now () - upload;
+        cycles = gBusCycles - cycles;
+
+        // let the display catch up until the next frame deadline
+        Run (start + period * (frame + 1));
+
+        printf ("%d,%llu,%llu,%llu,%.1f,%.1f\n", frame,
+            (unsigned long long)(gCounts.addressWrites + gCounts.dataWrites +
+                gCounts.bufferWrites + gCounts.otherWrites - before.addressWrites -
+                before.dataWrites - before.bufferWrites - before.otherWrites),
+            (unsigned long long)(gCounts.reads - before.reads),
+            (unsigned long long)cycles, (double)upload / PS_PER_NS / 1000.0,
+            (gFlips > flipsBefore) ?
+                (double)(gFlipSum - flipSumBefore) / PS_PER_NS / 1000.0 : -1.0);
+        fflush (stdout);
+    }
+
+    // BCM scan over the whole run, 16 rows of 4 bit planes per refresh
+    if (!gBlank) {
+        gUnblanked += Now () - gBlankEdge;
+    }
+    fprintf (stderr, "refresh rate %.1f Hz, unblanked %.1f%% of the time\n",
+        (double)(gLatches - latchStart) / 64.0 / ((double)(Now () - start) / 1e12),
+        100.0 * gUnblanked / (Now () - start));
+    if (gFlips > 0) {
+        fprintf (stderr, "swap latency average %.1f usec, max %.1f usec\n",
+            (double)gFlipSum / gFlips / PS_PER_NS / 1000.0,
+            (double)gFlipMax / PS_PER_NS / 1000.0);
+    }
+
+    // the panel has shown at least one full refresh of the last frame by now
+    mismatches = 0;
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        for (col = 0; col < DISPLAY_WIDTH; col++) {
+            if (gPanel[row][col] != gLevels[row][col]) {
+                mismatches++;
+            }
+        }
+    }
+    fprintf (stderr, "%d pixels on the panel differ from the last frame\n", mismatches);
+
+    delete pattern;
+    FpgaClose ();
+
+    gTop->final ();
+    delete gTop;
+    delete gContext;
+
+    return (mismatches == 0) ? 0 : 1;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// fpgasim.h interface, called by fpga.cpp
+//
+
+bool FpgaSimOpen (const char *dump)
+{
+    FpgaSimResetCounts ();
+    gHostMark = HostNow ();
+
+    return true;
+}
+
+
+void FpgaSimClose (void)
+{
+    fprintf (stderr, "gpmc: %llu address, %llu data, %llu buffer, %llu other writes, "
+        "%llu reads, %llu bus cycles\n",
+        (unsigned long long)gCounts.addressWrites, (unsigned long long)gCounts.dataWrites,
+        (unsigned long long)gCounts.bufferWrites, (unsigned long long)gCounts.otherWrites,
+        (unsigned long long)gCounts.reads, (unsigned long long)gBusCycles);
+}
+
+
+uint16_t FpgaSimRead16 (uint16_t address)
+{
+    uint16_t data;
+
+    Idle ();
+    gCounts.reads++;
+    data = BusRead (address >> 1);
+    gHostMark = HostNow ();
+
+    return data;
+}
+
+
+void FpgaSimWrite16 (uint16_t address, uint16_t data)
+{
+    Idle ();
+
+    switch (address) {
+        case FPGA_PANEL_ADDR_REG: gCounts.addressWrites++; break;
+        case FPGA_PANEL_DATA_REG: gCounts.dataWrites++; break;
+        case FPGA_PANEL_BUFFER_REG: gCounts.bufferWrites++; break;
+        default: gCounts.otherWrites++; break;
+    }
+
+    BusWrite (address >> 1, data);
+
+    // the present, time the swap from here
+    if (address == FPGA_PANEL_BUFFER_REG) {
+        gSelectTime = Now ();
+    }
+
+    gHostMark = HostNow ();
+}
+
+
+void FpgaSimGetFrame (uint16_t levels[DISPLAY_HEIGHT][DISPLAY_WIDTH])
+{
+    memcpy (levels, gPanel, sizeof (gPanel));
+}
+
+
+void FpgaSimGetCounts (FpgaSimCounts *counts)
+{
+    *counts = gCounts;
+}
+
+
+void FpgaSimResetCounts (void)
+{
+    memset (&gCounts, 0, sizeof (gCounts));
+}
+
+
+uint16_t FpgaSimGetDimming (void)
+{
+    return gTop->rootp->beagle01__DOT__mtrx_level;
+}
+
+
+uint16_t FpgaSimGetTestPin (void)
+{
+    return gTop->rootp->beagle01__DOT__mtrx_test_pin;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// simulation time
+//
+
+static int64_t Now (void)
+{
+    return gContext->time ();
+}
+
+
+static int64_t HostNow (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+// evaluate every scheduled event up to until, bus inputs hold their values
+static void Run (int64_t until)
+{
+    uint64_t next;
+
+    while (1) {
+        gTop->eval ();
+        Monitor ();
+        if (!gTop->eventsPending ()) {
+            break;
+        }
+        next = gTop->nextTimeSlot ();
+        if (next > (uint64_t)until) {
+            break;
+        }
+        gContext->time (next);
+    }
+
+    gContext->time (until);
+}
+
+
+// pass the host time since the previous access to the simulation as an idle bus
+static void Idle (void)
+{
+    int64_t idle = (HostNow () - gHostMark) * PS_PER_NS;
+
+    if (idle > MAX_IDLE_PS) {
+        idle = MAX_IDLE_PS;
+    }
+
+    // stay aligned to the bus clock
+    idle -= idle % FCLK_PS;
+    if (idle > 0) {
+        Run (Now () + idle);
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// AM335x GPMC asynchronous multiplexed bus cycles, one call to Tick per functional clock
+//
+
+static void BusWrite (uint16_t address, uint16_t data)
+{
+    int32_t cycle;
+
+    for (cycle = 0; cycle < WR_CYCLE_TIME; cycle++) {
+        gTop->gpmc_csn = (cycle < CS_ON_TIME) || (cycle >= CS_WR_OFF_TIME);
+        gTop->gpmc_advn = (cycle < ADV_ON_TIME) || (cycle >= ADV_WR_OFF_TIME);
+        gTop->gpmc_oen = 1;
+        gTop->gpmc_wen = (cycle < WE_ON_TIME) || (cycle >= WE_OFF_TIME);
+        gTop->gpmc_ben = 0;
+        gTop->gpmc_ad = (cycle < WR_DATA_ON_ADMUX_BUS) ? address : data;
+        Tick ();
+    }
+
+    for (cycle = 0; cycle < CYCLE_2_CYCLE_DELAY; cycle++) {
+        gTop->gpmc_csn = 1;
+        gTop->gpmc_advn = 0;
+        gTop->gpmc_oen = 1;
+        gTop->gpmc_wen = 1;
+        gTop->gpmc_ben = 3;
+        Tick ();
+    }
+}
+
+
+static uint16_t BusRead (uint16_t address)
+{
+    uint16_t data = 0xffff;
+    int32_t cycle;
+
+    for (cycle = 0; cycle < RD_CYCLE_TIME; cycle++) {
+
+        // sampled on the clock edge that starts the cycle, like the Verilog host model
+        if ((cycle == RD_ACCESS_TIME) && gTop->gpmc_ad__en) {
+            data = gTop->gpmc_ad__out;
+        }
+
+        gTop->gpmc_csn = (cycle < CS_ON_TIME) || (cycle >= CS_RD_OFF_TIME);
+        gTop->gpmc_advn = (cycle < ADV_ON_TIME) || (cycle >= ADV_RD_OFF_TIME);
+        gTop->gpmc_oen = (cycle < OE_ON_TIME) || (cycle >= OE_OFF_TIME);
+        gTop->gpmc_wen = 1;
+        gTop->gpmc_ben = 0;
+        gTop->gpmc_ad = address;
+        Tick ();
+    }
+
+    for (cycle = 0; cycle < CYCLE_2_CYCLE_DELAY; cycle++) {
+        gTop->gpmc_csn = 1;
+        gTop->gpmc_advn = 0;
+        gTop->gpmc_oen = 1;
+        gTop->gpmc_wen = 1;
+        gTop->gpmc_ben = 3;
+        Tick ();
+    }
+
+    return data;
+}
+
+
+static void Tick (void)
+{
+    gBusCycles++;
+    Run (Now () + FCLK_PS);
+}
+
+
+//---------------------------------------------------------------------------------------------
+// watch the matrix controller and its outputs after every evaluation
+//
+
+static void Monitor (void)
+{
+    uint8_t current, sclk, latch, blank;
+
+    // buffer swap seen by the bus side of the design
+    current = gTop->rootp->beagle01__DOT__mtrx_current;
+    if (current != gCurrent) {
+        gCurrent = current;
+        gFlips++;
+        if (gSelectTime >= 0) {
+            int64_t latency = Now () - gSelectTime;
+            gFlipSum += latency;
+            if (latency > gFlipMax) {
+                gFlipMax = latency;
+            }
+            gSelectTime = -1;
+        }
+    }
+
+    // shift in one column of both halves on the rising edge of sclk
+    sclk = gTop->PMOD2_9_LVDS4_P;
+    if (sclk && !gSclk && (gShiftCount < SHIFT_LENGTH)) {
+        if (gShiftCount == 0) {
+            gShiftPlane = gTop->rootp->beagle01__DOT__matrix__DOT__rd_bit;
+        }
+        gShift[gShiftCount++] =
+            (gTop->PMOD1_1_LVDS8_P << 5) | (gTop->PMOD1_2_LVDS8_N << 4) |
+            (gTop->PMOD1_3_LVDS7_P << 3) | (gTop->PMOD1_7_LVDS1_P << 2) |
+            (gTop->PMOD1_8_LVDS1_N << 1) | gTop->PMOD1_9_LVDS2_P;
+    }
+    gSclk = sclk;
+
+    // latch the shifted bit plane into the row on the address lines
+    latch = gTop->PMOD2_8_LVDS3_N;
+    if (latch && !gLatch) {
+        gLatches++;
+        Latch ();
+    }
+    gLatch = latch;
+
+    // time spent unblanked
+    blank = gTop->PMOD2_7_LVDS3_P;
+    if (blank != gBlank) {
+        if (!blank) {
+            gBlankEdge = Now ();
+        } else {
+            gUnblanked += Now () - gBlankEdge;
+        }
+        gBlank = blank;
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// store a latched bit plane in the rebuilt image
+//
+// Shift n holds column n of the frame memory for n < 96 and column n + 32 after that,
+// bit 7 of that column picks rows 0-31 or 32-63. r0 / g0 / b0 carry the row on the address
+// lines and r1 / g1 / b1 the row 16 below it.
+//
+
+static void Latch (void)
+{
+    int32_t a, i, col, x, y, half;
+    uint16_t mask;
+
+    a = (gTop->PMOD2_4_LVDS5_N << 3) | (gTop->PMOD2_3_LVDS5_P << 2) |
+        (gTop->PMOD2_2_LVDS6_N << 1) | gTop->PMOD2_1_LVDS6_P;
+    mask = (1 << (8 + gShiftPlane)) | (1 << (4 + gShiftPlane)) | (1 << gShiftPlane);
+
+    for (i = 0; i < gShiftCount; i++) {
+        col = (i < 96) ? i : i + 32;
+        x = col & 0x7f;
+        for (half = 0; half < 2; half++) {
+            uint8_t rgb = gShift[i] >> (half ? 0 : 3);
+            y = ((col >> 7) << 5) | (half << 4) | a;
+            if ((y >= DISPLAY_HEIGHT) || (x >= DISPLAY_WIDTH)) {
+                continue;
+            }
+            gPanel[y][x] = (gPanel[y][x] & ~mask) |
+                (((rgb >> 2) & 1) << (8 + gShiftPlane)) |
+                (((rgb >> 1) & 1) << (4 + gShiftPlane)) |
+                ((rgb & 1) << gShiftPlane);
+        }
+    }
+
+    gShiftCount = 0;
+}
@@ -0,0 +1,64 @@
+//=============================================================================================
+// SparkFun / Adafruit 32x32 LED Panel Driver
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+// 
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+// Behavioural model of the dpram8192x12 block RAM core for co-simulation: simple dual port,
+// write on port a, read on port b with one clock of latency and no output registers.
+
+`timescale 1ns / 1ps
+
+module dpram8192x12
+(
+	input	wire			clka,
+	input	wire	[0:0]	wea,
+	input	wire	[12:0]	addra,
+	input	wire	[11:0]	dina,
+	input	wire			clkb,
+	input	wire	[12:0]	addrb,
+	output	reg		[11:0]	doutb
+);
+
+reg [11:0] mem [0:8191];
+
+integer i;
+
+initial
+begin
+	for (i = 0; i < 8192; i = i + 1)
+	begin
+		mem[i] = 0;
+	end
+	doutb = 0;
+end
+
+always @ (posedge clka)
+begin
+	if (wea)
+	begin
+		mem[addra] <= dina;
+	end
+end
+
+always @ (posedge clkb)
+begin
+	doutb <= mem[addrb];
+end
+
+endmodule
@@ -149,6 +149,10 @@ wire [16:1] sb_addr;
 wire [15:0] sb_wr_data;
 reg [15:0] sb_rd_data;
 
+// matrix status read back over the bus, assigned below with the matrix registers
+wire [15:0] mtrx_status;
+wire [15:0] mtrx_swaps_rd;
+
 gpmc_target gpmc_target
 (
     .rst_n              (rst_n),
@@ -210,6 +214,8 @@ begin
 				5: sb_rd_data <= 16'hbeef;
 				6: sb_rd_data <= 16'hcafe;
 				7: sb_rd_data <= 16'hfeed;
+				10: sb_rd_data <= mtrx_status;
+				13: sb_rd_data <= mtrx_swaps_rd;
             endcase
         end
 	end
@@ -226,6 +232,8 @@ reg [13:0] mtrx_wr_addr;
 reg [11:0] mtrx_wr_data;
 reg mtrx_select_yy;
 reg mtrx_current;
+reg mtrx_current_z;
+reg [15:0] mtrx_swaps;
 reg [8:0] mtrx_level;
 
 always @ (posedge clk100 or negedge rst_n)
@@ -307,14 +315,28 @@ begin
 	begin
 		mtrx_current_y <= 0;
 		mtrx_current <= 0;
+		mtrx_current_z <= 0;
+		mtrx_swaps <= 0;
 	end
 	else
 	begin
 		mtrx_current_y <= mtrx_current_yy;
 		mtrx_current <= mtrx_current_y;
+
+		// count buffer swaps so software can pace itself to the display refresh
+		mtrx_current_z <= mtrx_current;
+		if (mtrx_current != mtrx_current_z)
+		begin
+			mtrx_swaps <= mtrx_swaps + 1;
+		end
 	end
 end
 
+// read 0x14: bit 0 = buffer being scanned out, bit 1 = buffer selected by software
+// read 0x1a: number of buffer swaps since reset
+assign mtrx_status = { 14'd0, mtrx_select_yy, mtrx_current };
+assign mtrx_swaps_rd = mtrx_swaps;
+
 matrix matrix
 (
     .rst_n					(rst_n),
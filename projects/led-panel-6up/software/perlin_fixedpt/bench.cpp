@@ -0,0 +1,100 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+#include "globals.h"
+#include "pattern.h"
+#include "tiles.h"
+#include "perlin.h"
+#include "benchmark.h"
+
+// levels the patterns draw into, never uploaded
+uint16_t gLevels[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+// linear light, for patterns set to draw it
+uint16_t gLinear[3][DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+// palette indices, for patterns set to draw them
+uint8_t gIndices[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+uint16_t gPalette[PALETTE_SIZE];
+int32_t gPaletteRotate = 0;
+
+
+//---------------------------------------------------------------------------------------------
+// patterns with the same settings as their run programs
+//
+
+static Pattern *NewPerlin (PerlinNumeric numeric)
+{
+    Perlin *pattern = new Perlin (DISPLAY_WIDTH, DISPLAY_HEIGHT,
+        2, 6.0/64.0, 1.0/64.0, 256.0, 0.005);
+    pattern->setNumeric (numeric);
+    return pattern;
+}
+
+
+static Pattern *CreatePerlin (void)
+{
+    return NewPerlin (PERLIN_Q8_8);
+}
+
+
+static Pattern *CreatePerlinLoop (void)
+{
+    Perlin *pattern = new Perlin (DISPLAY_WIDTH, DISPLAY_HEIGHT,
+        2, 6.0/64.0, 1.0/64.0, 256.0, 0.005);
+    pattern->setNumeric (PERLIN_Q8_8);
+    pattern->setLoop (true);
+    return pattern;
+}
+
+
+static Pattern *CreatePerlinFloat (void)
+{
+    return NewPerlin (PERLIN_FLOAT);
+}
+
+
+static Pattern *CreatePerlinQ16 (void)
+{
+    return NewPerlin (PERLIN_Q16_16);
+}
+
+
+static const BenchPattern gPatterns[] = {
+    { "pf2",        CreatePerlin      },
+    { "pf2-loop",   CreatePerlinLoop  },
+    { "pf2-float",  CreatePerlinFloat },
+    { "pf2-q16.16", CreatePerlinQ16   }
+};
+
+
+int main (int argc, char *argv[])
+{
+    return BenchMain (argc, argv, gPatterns, sizeof (gPatterns) / sizeof (gPatterns[0]));
+}
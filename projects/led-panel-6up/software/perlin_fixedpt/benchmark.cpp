@@ -0,0 +1,479 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <new>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "globals.h"
+#include "pattern.h"
+#include "frameloop.h"
+#include "triplebuffer.h"
+#include "dither.h"
+#include "palette.h"
+#include "calibrate.h"
+#include "gammalut.h"
+#include "tiles.h"
+#include "benchmark.h"
+
+#define MAX_SELECTED 16
+#define MAX_NAME 64
+
+// allocations made while counting is on
+static bool gCounting = false;
+static uint64_t gAllocs = 0;
+static uint64_t gAllocBytes = 0;
+
+// quantizers for -l, fed the way the pipeline feeds them
+static LinearFrame gLinearFrame;
+static IndexedFrame gIndexedFrame;
+static Frame gFrame;
+static TemporalDither gTemporal;
+static OrderedDither gOrdered;
+
+static const char *gQuantizeNames[QUANTIZE_MODES] = {
+    "", "-temporal", "-ordered", "-palette"
+};
+
+// -m, every panel a little dimmer with a little of each channel in the others
+static PanelCalibration gCalibration;
+static bool gCalibrate = false;
+static LinearFrame gCalibrated;
+static const float gCrossTalk[3][3] = {
+    { 0.96, 0.02, 0.02 }, { 0.02, 0.96, 0.02 }, { 0.02, 0.02, 0.96 }
+};
+
+// random 8-bit colors and frames the -m stages are timed on
+static uint8_t gColors[DISPLAY_HEIGHT][DISPLAY_WIDTH][3];
+static Frame gStageFrame;
+static LinearFrame gStageLinear;
+
+// a stage timed on its own with -m
+typedef struct {
+    const char *name;
+    void (*run) (void);
+} BenchStage;
+
+static void StageGamma (void);
+static void StageCalibrate (void);
+static void StageCalibrateLinear (void);
+
+static const BenchStage gStages[] = {
+    { "gamma-lut",        StageGamma           },
+    { "calibrate",        StageCalibrate       },
+    { "calibrate-linear", StageCalibrateLinear }
+};
+
+#define NUM_STAGES (int32_t)(sizeof (gStages) / sizeof (gStages[0]))
+
+// perf counter group, leader counts cache references, the other one cache misses
+typedef struct {
+    int refs;
+    int misses;
+} PerfCounters;
+
+static void PerfOpen (PerfCounters *perf);
+static void PerfStart (PerfCounters *perf);
+static void PerfStop (PerfCounters *perf, int64_t *refs, int64_t *misses);
+static void PerfClose (PerfCounters *perf);
+static int64_t Now (void);
+static void Render (Pattern *pattern, QuantizeMode quantize);
+static void Print (const char *name, int32_t frames, int64_t elapsed, int64_t refs,
+    int64_t misses);
+static void TimeStage (const BenchStage *stage, int32_t frames, int32_t warmup);
+
+
+//---------------------------------------------------------------------------------------------
+// allocation counting
+//
+
+void *operator new (size_t size)
+{
+    void *p;
+
+    if (gCounting) {
+        gAllocs++;
+        gAllocBytes += size;
+    }
+
+    p = malloc (size ? size : 1);
+    if (p == NULL) {
+        throw std::bad_alloc ();
+    }
+
+    return p;
+}
+
+
+void *operator new[] (size_t size)
+{
+    return operator new (size);
+}
+
+
+void operator delete (void *p) throw ()
+{
+    free (p);
+}
+
+
+void operator delete[] (void *p) throw ()
+{
+    free (p);
+}
+
+
+//---------------------------------------------------------------------------------------------
+// run the benchmarks
+//
+
+int BenchMain (int argc, char *argv[], const BenchPattern *patterns, int32_t count)
+{
+    const char *selected[MAX_SELECTED];
+    char name[MAX_NAME];
+    int32_t numSelected = 0;
+    int32_t frames = 1000;
+    int32_t warmup = 10;
+    bool header = true;
+    int32_t quantize = QUANTIZE_NONE;
+    int32_t threads = 1;
+    int32_t i, j, frame;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "n:w:p:ql:j:m")) != -1) {
+        switch (opt) {
+            case 'n': frames = atoi (optarg); break;
+            case 'w': warmup = atoi (optarg); break;
+            case 'p':
+                if (numSelected < MAX_SELECTED) {
+                    selected[numSelected++] = optarg;
+                }
+                break;
+            case 'q': header = false; break;
+            case 'l': quantize = atoi (optarg); break;
+            case 'j': threads = atoi (optarg); break;
+            case 'm': gCalibrate = true; break;
+            default: frames = 0; break;
+        }
+    }
+
+    if ((frames <= 0) || (quantize < 0) || (quantize >= QUANTIZE_MODES) ||
+            (threads < 1) || (threads > TILES_MAX_THREADS)) {
+        fprintf (stderr, "usage: %s [-n frames] [-w warm up frames] [-p pattern] [-q] "
+            "[-l quantizer] [-j threads] [-m]\n", argv[0]);
+        return -1;
+    }
+
+    if (!TilesStart (threads)) {
+        return -1;
+    }
+
+    for (i = 0; gCalibrate && (i < PANELS); i++) {
+        gCalibration.set (i, 0.99, gCrossTalk);
+    }
+
+    if (header) {
+        printf ("pattern,width,height,frames,ns_per_frame,ns_per_pixel,allocs,alloc_bytes,"
+            "cache_refs,cache_misses\n");
+    }
+
+    for (i = 0; i < count; i++) {
+
+        // skip patterns not asked for
+        if (numSelected > 0) {
+            for (j = 0; j < numSelected; j++) {
+                if (!strcmp (selected[j], patterns[i].name)) {
+                    break;
+                }
+            }
+            if (j == numSelected) {
+                continue;
+            }
+        }
+
+        Pattern *pattern = patterns[i].create ();
+        PerfCounters perf;
+        int64_t start, elapsed, refs, misses;
+
+        // only some patterns can draw palette indices
+        pattern->setLinear ((quantize == QUANTIZE_TEMPORAL) || (quantize == QUANTIZE_ORDERED));
+        if (!pattern->setIndexed (quantize == QUANTIZE_PALETTE)) {
+            delete pattern;
+            continue;
+        }
+
+        pattern->init ();
+        gTemporal.reset ();
+        for (frame = 0; frame < warmup; frame++) {
+            Render (pattern, (QuantizeMode)quantize);
+        }
+
+        PerfOpen (&perf);
+
+        gAllocs = 0;
+        gAllocBytes = 0;
+        gCounting = true;
+        PerfStart (&perf);
+        start = Now ();
+
+        for (frame = 0; frame < frames; frame++) {
+            Render (pattern, (QuantizeMode)quantize);
+        }
+
+        elapsed = Now () - start;
+        PerfStop (&perf, &refs, &misses);
+        gCounting = false;
+
+        PerfClose (&perf);
+
+        snprintf (name, sizeof (name), "%s%s%s", patterns[i].name, gQuantizeNames[quantize],
+            gCalibrate ? "-calibrated" : "");
+        Print (name, frames, elapsed, refs, misses);
+
+        delete pattern;
+    }
+
+    // the calibration on its own, next to the gamma lookup every 12-bit pattern already does
+    for (i = 0; gCalibrate && (i < NUM_STAGES); i++) {
+        TimeStage (&gStages[i], frames, warmup);
+    }
+
+    TilesStop ();
+
+    return 0;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// one frame, with -l also the copy and quantizer or palette lookup the pipeline adds, and
+// with -m the panel calibration
+//
+
+static void Render (Pattern *pattern, QuantizeMode quantize)
+{
+    pattern->next ();
+
+    if (quantize == QUANTIZE_PALETTE) {
+        memcpy (gIndexedFrame.indices, gIndices, sizeof (gIndices));
+        memcpy (gIndexedFrame.palette, gPalette, sizeof (gPalette));
+        gIndexedFrame.rotate = gPaletteRotate;
+        PaletteMap (&gIndexedFrame.indices[0][0], gIndexedFrame.palette, gIndexedFrame.rotate,
+            &gFrame.levels[0][0]);
+        if (gCalibrate) {
+            gCalibration.apply (&gFrame, &gFrame);
+        }
+    } else if (quantize != QUANTIZE_NONE) {
+        const LinearFrame *linear = &gLinearFrame;
+        memcpy (gLinearFrame.linear, gLinear, sizeof (gLinear));
+        if (gCalibrate) {
+            gCalibration.apply (&gLinearFrame, &gCalibrated);
+            linear = &gCalibrated;
+        }
+        if (quantize == QUANTIZE_TEMPORAL) {
+            gTemporal.quantize (linear, &gFrame);
+        } else {
+            gOrdered.quantize (linear, &gFrame);
+        }
+    } else if (gCalibrate) {
+        memcpy (gFrame.levels, gLevels, sizeof (gLevels));
+        gCalibration.apply (&gFrame, &gFrame);
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// -m stages, each over a whole frame of fixed random input
+//
+
+// three gamma lookups per pixel, as pattern.cpp builds its 12-bit colors
+static void StageGamma (void)
+{
+    int32_t row, col;
+
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        for (col = 0; col < DISPLAY_WIDTH; col++) {
+            const uint8_t *c = gColors[row][col];
+            gStageFrame.levels[row][col] = (gammaLut[c[0]] << 8) | (gammaLut[c[1]] << 4) |
+                gammaLut[c[2]];
+        }
+    }
+}
+
+
+// the panel tables, in place
+static void StageCalibrate (void)
+{
+    gCalibration.apply (&gStageFrame, &gStageFrame);
+}
+
+
+// the Q12 matrix on linear light
+static void StageCalibrateLinear (void)
+{
+    gCalibration.apply (&gStageLinear, &gCalibrated);
+}
+
+
+static void TimeStage (const BenchStage *stage, int32_t frames, int32_t warmup)
+{
+    PerfCounters perf;
+    int64_t start, elapsed, refs, misses;
+    int32_t row, col, i, frame;
+
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        for (col = 0; col < DISPLAY_WIDTH; col++) {
+            for (i = 0; i < 3; i++) {
+                gColors[row][col][i] = rand () & 0xff;
+                gStageLinear.linear[i][row][col] = rand () & 0xffff;
+            }
+            gStageFrame.levels[row][col] = rand () & 0xfff;
+        }
+    }
+
+    for (frame = 0; frame < warmup; frame++) {
+        stage->run ();
+    }
+
+    PerfOpen (&perf);
+
+    gAllocs = 0;
+    gAllocBytes = 0;
+    gCounting = true;
+    PerfStart (&perf);
+    start = Now ();
+
+    for (frame = 0; frame < frames; frame++) {
+        stage->run ();
+    }
+
+    elapsed = Now () - start;
+    PerfStop (&perf, &refs, &misses);
+    gCounting = false;
+
+    PerfClose (&perf);
+
+    Print (stage->name, frames, elapsed, refs, misses);
+}
+
+
+//---------------------------------------------------------------------------------------------
+// one CSV line
+//
+
+static void Print (const char *name, int32_t frames, int64_t elapsed, int64_t refs,
+    int64_t misses)
+{
+    printf ("%s,%d,%d,%d,%.1f,%.3f,%llu,%llu,%lld,%lld\n", name,
+        DISPLAY_WIDTH, DISPLAY_HEIGHT, frames, (double)elapsed / frames,
+        (double)elapsed / frames / (DISPLAY_WIDTH * DISPLAY_HEIGHT),
+        (unsigned long long)gAllocs, (unsigned long long)gAllocBytes,
+        (long long)refs, (long long)misses);
+    fflush (stdout);
+}
+
+
+//---------------------------------------------------------------------------------------------
+// hardware cache counters for the calling thread
+//
+
+static int PerfEventOpen (uint64_t config, int group)
+{
+    struct perf_event_attr attr;
+
+    memset (&attr, 0, sizeof (attr));
+    attr.size = sizeof (attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (group < 0) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return syscall (__NR_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+
+static void PerfOpen (PerfCounters *perf)
+{
+    perf->refs = PerfEventOpen (PERF_COUNT_HW_CACHE_REFERENCES, -1);
+    perf->misses = (perf->refs < 0) ? -1 :
+        PerfEventOpen (PERF_COUNT_HW_CACHE_MISSES, perf->refs);
+}
+
+
+static void PerfStart (PerfCounters *perf)
+{
+    if (perf->refs >= 0) {
+        ioctl (perf->refs, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl (perf->refs, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+
+static void PerfStop (PerfCounters *perf, int64_t *refs, int64_t *misses)
+{
+    uint64_t value;
+
+    *refs = -1;
+    *misses = -1;
+
+    if (perf->refs < 0) {
+        return;
+    }
+
+    ioctl (perf->refs, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    if (read (perf->refs, &value, sizeof (value)) == sizeof (value)) {
+        *refs = value;
+    }
+    if ((perf->misses >= 0) &&
+            (read (perf->misses, &value, sizeof (value)) == sizeof (value))) {
+        *misses = value;
+    }
+}
+
+
+static void PerfClose (PerfCounters *perf)
+{
+    if (perf->misses >= 0) {
+        close (perf->misses);
+    }
+    if (perf->refs >= 0) {
+        close (perf->refs);
+    }
+}
+
+
+static int64_t Now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
@@ -0,0 +1,60 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#ifndef __benchmark_h_
+#define __benchmark_h_
+
+// Headless pattern benchmark.
+//
+// Each pattern is created, initialized and run for a few warm up frames, then timed over
+// a fixed number of next () calls with no FPGA attached. The canvas is whatever
+// DISPLAY_WIDTH x DISPLAY_HEIGHT the benchmark was compiled with, so the Makefile builds one
+// binary per canvas size. Allocations are counted by replacing the global operator new, and
+// cache misses come from perf_event_open when the kernel allows it, -1 otherwise. With -l the
+// patterns draw gLinear and every frame also goes through that quantizer, as numbered for
+// the run programs' -q, and the pattern names get a -temporal or -ordered suffix. With -l 3
+// the patterns that can draw palette indices do, and are mapped through their palette as a
+// -palette run; the others are skipped. With -j the patterns that draw in bands spread them
+// over that many threads, see tiles.h. With -m every frame is also corrected by a panel
+// calibration that scales and mixes every channel, the names get a -calibrated suffix, and
+// the correction is then timed on its own next to a frame of gammaLut lookups, as the
+// gamma-lut, calibrate and calibrate-linear lines.
+//
+// Output is one CSV line per pattern on stdout after a header line:
+//   pattern,width,height,frames,ns_per_frame,ns_per_pixel,allocs,alloc_bytes,
+//   cache_refs,cache_misses
+
+// creates a pattern at DISPLAY_WIDTH x DISPLAY_HEIGHT
+typedef Pattern *(*BenchFactory) (void);
+
+typedef struct {
+    const char *name;
+    BenchFactory create;
+} BenchPattern;
+
+// run the patterns selected on the command line, all of them by default
+//   -n frames   -w warm up frames   -p pattern name (repeatable)   -q (no header line)
+//   -l quantizer (1 = temporal dither, 2 = ordered dither, 3 = palette)   -j threads
+//   -m (calibrate every frame and time the calibration)
+int BenchMain (int argc, char *argv[], const BenchPattern *patterns, int32_t count);
+
+#endif
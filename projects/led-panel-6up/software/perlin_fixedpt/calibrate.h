@@ -0,0 +1,90 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#ifndef __calibrate_h_
+#define __calibrate_h_
+
+// Per panel color correction.
+//
+// Panels from different batches have different white points. Each panel can get a 3x3
+// matrix and a gain, applied to its linear red, green and blue. The gain is folded into the
+// matrix as Q12 fixed point when the file is loaded. Linear frames, -q 1 or 2, are corrected
+// in 16 bits before the quantizer, so they are rounded to 4 bits once, with the dither, and a
+// few percent of gain still moves every level instead of vanishing into the 15 PWM steps.
+// Panel levels are already linear, PWM duty in 15ths, so for 12-bit frames every one of the
+// 4096 colors is corrected at load time into a table per panel, and calibrating a frame
+// costs one lookup per pixel, the same as the gammaLut lookup that drew it. Those levels are
+// rounded twice, so small gains only move the levels that round across a step.
+//
+// The file has one line per corrected panel, panels left out are not touched:
+//   panel gain m00 m01 m02 m10 m11 m12 m20 m21 m22
+// where panel counts left to right then top to bottom in PANEL_WIDTH x PANEL_HEIGHT steps,
+// and the corrected red is gain * (m00 * red + m01 * green + m02 * blue) and so on. Gain
+// times each matrix value must be within -CALIBRATE_MAX to CALIBRATE_MAX.
+// Anything after a # is a comment.
+
+#define PANELS_ACROSS (DISPLAY_WIDTH / PANEL_WIDTH)
+#define PANELS_DOWN   (DISPLAY_HEIGHT / PANEL_HEIGHT)
+#define PANELS        (PANELS_ACROSS * PANELS_DOWN)
+
+// Q12 matrix, and the largest value that keeps three 16-bit products summed in 32 bits
+#define CALIBRATE_SHIFT 12
+#define CALIBRATE_ONE   (1 << CALIBRATE_SHIFT)
+#define CALIBRATE_MAX   2
+
+class PanelCalibration
+{
+    public:
+
+        // constructor
+        PanelCalibration (void);
+
+        // destructor
+        ~PanelCalibration (void) { }
+
+        // read corrections from path, returns false and prints the problem on error
+        bool load (const char *path);
+
+        // correct one panel, returns false if a value is out of range
+        bool set (int32_t panel, float gain, const float matrix[3][3]);
+
+        // true once a file has been loaded or a panel set
+        bool isLoaded (void) {
+            return m_loaded;
+        }
+
+        // correct every pixel of in into out, clamped to the 16-bit range
+        void apply (const LinearFrame *in, LinearFrame *out);
+
+        // correct every pixel of in into out through the panel tables, in can be out
+        void apply (const Frame *in, Frame *out);
+
+    private:
+
+        // gain times matrix for each panel, whether that leaves it untouched, and its table
+        int32_t m_matrix[PANELS][3][3];
+        bool m_identity[PANELS];
+        uint16_t m_lut[PANELS][4096];
+        bool m_loaded;
+};
+
+#endif
@@ -0,0 +1,103 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+#include "globals.h"
+#include "pattern.h"
+#include "tiles.h"
+#include "perlin.h"
+#include "golden.h"
+
+// levels the patterns draw into, compared with the golden frames
+uint16_t gLevels[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+// linear light, for patterns set to draw it
+uint16_t gLinear[3][DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+// palette indices, for patterns set to draw them
+uint8_t gIndices[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+uint16_t gPalette[PALETTE_SIZE];
+int32_t gPaletteRotate = 0;
+
+
+//---------------------------------------------------------------------------------------------
+// patterns with the same settings as their run programs
+//
+
+static Pattern *NewPerlin (PerlinNumeric numeric)
+{
+    Perlin *pattern = new Perlin (DISPLAY_WIDTH, DISPLAY_HEIGHT,
+        2, 6.0/64.0, 1.0/64.0, 256.0, 0.005);
+    pattern->setNumeric (numeric);
+    return pattern;
+}
+
+
+static Pattern *CreatePerlin (void)
+{
+    return NewPerlin (PERLIN_Q8_8);
+}
+
+
+// a one cell loop, so the frames cover it wrapping twice
+static Pattern *CreatePerlinLoop (void)
+{
+    Perlin *pattern = new Perlin (DISPLAY_WIDTH, DISPLAY_HEIGHT,
+        2, 6.0/64.0, 1.0/64.0, 1.0, 0.005);
+    pattern->setNumeric (PERLIN_Q8_8);
+    pattern->setLoop (true);
+    return pattern;
+}
+
+
+// the same noise worked out in float and finer fixed point, checked against the q8.8
+// frames, the noise rounds differently so colors can come out a few levels off
+static Pattern *CreatePerlinFloat (void)
+{
+    return NewPerlin (PERLIN_FLOAT);
+}
+
+
+static Pattern *CreatePerlinQ16 (void)
+{
+    return NewPerlin (PERLIN_Q16_16);
+}
+
+
+static const GoldenPattern gPatterns[] = {
+    { "pf2",        "pf2",      CreatePerlin,      0 },
+    { "pf2-loop",   "pf2-loop", CreatePerlinLoop,  0 },
+    { "pf2-float",  "pf2",      CreatePerlinFloat, 3 },
+    { "pf2-q16.16", "pf2",      CreatePerlinQ16,   3 }
+};
+
+
+int main (int argc, char *argv[])
+{
+    return GoldenMain (argc, argv, gPatterns, sizeof (gPatterns) / sizeof (gPatterns[0]));
+}
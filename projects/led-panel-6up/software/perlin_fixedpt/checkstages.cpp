@@ -0,0 +1,655 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "globals.h"
+#include "pattern.h"
+#include "hueconv.h"
+#include "triplebuffer.h"
+#include "dither.h"
+#include "calibrate.h"
+#include "dimming.h"
+#include "power.h"
+
+// Checks of the hue conversion kernels and the present thread's stages on fixed frames.
+//
+// Each check builds its frames from rand () seeded with a fixed value, runs one stage of
+// the pipeline over them and tests a property the stage promises, printing ok or FAILED
+// with the numbers behind it. Returns 0 if every check selected with -p passed.
+
+#define MAX_SELECTED 16
+#define MAX_PATH 256
+
+// seed for the random frames
+#define STAGES_SEED 1
+
+// random frames and budgets the power limiter is checked with
+#define POWER_FRAMES 1000
+
+// longest hue row converted, not a multiple of any kernel's width so every tail is run
+#define HUE_PIXELS 1027
+
+// hue conversion kernels compared with the scalar one
+static const char *gHueKernels[] = { "neon", "sse4", "avx2" };
+#define NUM_HUE_KERNELS (int32_t)(sizeof (gHueKernels) / sizeof (gHueKernels[0]))
+
+typedef struct {
+    const char *name;
+    bool (*check) (void);
+} StageCheck;
+
+static LinearFrame gIn, gOut;
+static Frame gFrameA, gFrameB;
+
+// pattern.cpp draws into these, the checks don't
+uint16_t gLevels[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+uint16_t gLinear[3][DISPLAY_HEIGHT][DISPLAY_WIDTH];
+uint8_t gIndices[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+uint16_t gPalette[PALETTE_SIZE];
+int32_t gPaletteRotate = 0;
+
+// a hue row converted to 12-bit colors and to linear light, with and without brightness
+typedef struct {
+    uint16_t levels[2][HUE_PIXELS];
+    uint16_t linear[2][3][HUE_PIXELS];
+} HueOutput;
+
+static void RandomLinear (LinearFrame *linear);
+static void FlatLinear (LinearFrame *linear, uint16_t value);
+static void RandomLevels (Frame *frame);
+static double RmsError (const LinearFrame *linear, const Frame *frame, int32_t shift);
+static bool WriteCalibration (char *path, float gain);
+static void ConvertHues (HueOutput *out, const uint32_t *hues, const uint16_t *values,
+    int32_t count);
+
+
+//---------------------------------------------------------------------------------------------
+// hue conversion -- every kernel this cpu has converts rows exactly as the scalar one does,
+// for every row length up to HUE_PIXELS
+//
+
+static bool CheckHueKernels (void)
+{
+    static uint32_t hues[HUE_PIXELS];
+    static uint16_t values[HUE_PIXELS];
+    static HueOutput expected, actual;
+    int32_t i, k, count, tested = 0;
+
+    // random hues and brightnesses, then the ends of the wheel and of each step
+    for (i = 0; i < HUE_PIXELS; i++) {
+        hues[i] = ((uint32_t)rand () << 16 ^ rand ()) % HUE_WHEEL;
+        values[i] = rand () % (VALUE_ONE + 1);
+    }
+    for (i = 0; i < HUE_STEPS; i++) {
+        hues[4 * i] = i * HUE_ONE;
+        hues[4 * i + 1] = i * HUE_ONE + HUE_ONE / 2 - 1;
+        hues[4 * i + 2] = i * HUE_ONE + HUE_ONE / 2;
+        hues[4 * i + 3] = (i + 1) * HUE_ONE - 1;
+    }
+
+    for (k = 0; k < NUM_HUE_KERNELS; k++) {
+        if (!HueConvSetKernel (gHueKernels[k])) {
+            continue;
+        }
+        tested++;
+
+        for (count = 1; count <= HUE_PIXELS; count++) {
+            HueConvSetKernel ("scalar");
+            ConvertHues (&expected, &hues[HUE_PIXELS - count], &values[HUE_PIXELS - count],
+                count);
+            HueConvSetKernel (gHueKernels[k]);
+            ConvertHues (&actual, &hues[HUE_PIXELS - count], &values[HUE_PIXELS - count],
+                count);
+
+            if (memcmp (&expected, &actual, sizeof (expected))) {
+                printf ("hueconv-kernels: FAILED, %s differs from scalar on %d pixels\n",
+                    gHueKernels[k], count);
+                return false;
+            }
+        }
+    }
+
+    printf ("hueconv-kernels: ok, %d kernels match scalar\n", tested);
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// calibration -- an identity file leaves frames alone, a gain is rounded once in linear
+// light and to the nearest level through the tables
+//
+
+static bool CheckCalibrateIdentity (void)
+{
+    PanelCalibration calibration;
+    char path[MAX_PATH];
+    bool loaded;
+
+    if (!WriteCalibration (path, 1.0)) {
+        return false;
+    }
+    loaded = calibration.load (path);
+    unlink (path);
+
+    RandomLinear (&gIn);
+    memset (&gOut, 0, sizeof (gOut));
+    calibration.apply (&gIn, &gOut);
+
+    RandomLevels (&gFrameA);
+    memset (&gFrameB, 0, sizeof (gFrameB));
+    calibration.apply (&gFrameA, &gFrameB);
+
+    if (!loaded || memcmp (&gIn, &gOut, sizeof (gIn)) ||
+            memcmp (&gFrameA, &gFrameB, sizeof (gFrameA))) {
+        printf ("calibrate-identity: FAILED, identity file changed the frame\n");
+        return false;
+    }
+
+    printf ("calibrate-identity: ok\n");
+    return true;
+}
+
+
+static bool CheckCalibrateGain (void)
+{
+    PanelCalibration calibration;
+    OrderedDither ordered;
+    char path[MAX_PATH];
+    int32_t row, col, i, gain, off = 0;
+    int64_t before = 0, after = 0;
+    double ratio;
+    bool loaded;
+
+    if (!WriteCalibration (path, 0.97)) {
+        return false;
+    }
+    loaded = calibration.load (path);
+    unlink (path);
+    if (!loaded) {
+        return false;
+    }
+
+    // a smooth ramp, so the dithered sums follow the light instead of the threshold pattern
+    for (i = 0; i < 3; i++) {
+        for (row = 0; row < DISPLAY_HEIGHT; row++) {
+            for (col = 0; col < DISPLAY_WIDTH; col++) {
+                gIn.linear[i][row][col] = (row * DISPLAY_WIDTH + col) * 65535 /
+                    (DISPLAY_WIDTH * DISPLAY_HEIGHT - 1);
+            }
+        }
+    }
+
+    calibration.apply (&gIn, &gOut);
+
+    // the gain as the Q12 value the file is folded into
+    gain = lroundf (0.97f * CALIBRATE_ONE);
+    for (i = 0; i < 3; i++) {
+        for (row = 0; row < DISPLAY_HEIGHT; row++) {
+            for (col = 0; col < DISPLAY_WIDTH; col++) {
+                if (gOut.linear[i][row][col] != ((gain * gIn.linear[i][row][col] +
+                        CALIBRATE_ONE / 2) >> CALIBRATE_SHIFT)) {
+                    off++;
+                }
+            }
+        }
+    }
+
+    // levels through the tables, every channel to the nearest level
+    RandomLevels (&gFrameA);
+    calibration.apply (&gFrameA, &gFrameB);
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        for (col = 0; col < DISPLAY_WIDTH; col++) {
+            for (i = 0; i < 3; i++) {
+                int32_t level = (gFrameA.levels[row][col] >> (8 - 4 * i)) & 0xf;
+                if (((gFrameB.levels[row][col] >> (8 - 4 * i)) & 0xf) !=
+                        ((gain * level + CALIBRATE_ONE / 2) >> CALIBRATE_SHIFT)) {
+                    off++;
+                }
+            }
+        }
+    }
+
+    ordered.quantize (&gIn, &gFrameA);
+    ordered.quantize (&gOut, &gFrameB);
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        for (col = 0; col < DISPLAY_WIDTH; col++) {
+            before += (gFrameA.levels[row][col] >> 8) & 0xf;
+            after += (gFrameB.levels[row][col] >> 8) & 0xf;
+        }
+    }
+    ratio = (double)after / before;
+
+    if ((off > 0) || (ratio < 0.96) || (ratio > 0.98)) {
+        printf ("calibrate-gain: FAILED, %d channels off, dithered levels scaled by %.4f\n",
+            off, ratio);
+        return false;
+    }
+
+    printf ("calibrate-gain: ok, dithered levels scaled by %.4f\n", ratio);
+    return true;
+}
+
+
+// random matrices up to CALIBRATE_MAX on every panel, so the sums run past both ends
+static bool CheckCalibrateMatrix (void)
+{
+    PanelCalibration calibration;
+    float m[PANELS][3][3];
+    int32_t panel, row, col, i, j, off = 0;
+
+    for (panel = 0; panel < PANELS; panel++) {
+        for (i = 0; i < 3; i++) {
+            for (j = 0; j < 3; j++) {
+                m[panel][i][j] = (rand () % 4001 - 2000) / 1000.0f;
+            }
+        }
+        if (!calibration.set (panel, 1.0, m[panel])) {
+            printf ("calibrate-matrix: FAILED, panel %d not set\n", panel);
+            return false;
+        }
+    }
+
+    RandomLinear (&gIn);
+    calibration.apply (&gIn, &gOut);
+
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        for (col = 0; col < DISPLAY_WIDTH; col++) {
+            panel = (row / PANEL_HEIGHT) * PANELS_ACROSS + col / PANEL_WIDTH;
+            for (i = 0; i < 3; i++) {
+                int64_t sum = CALIBRATE_ONE / 2;
+                for (j = 0; j < 3; j++) {
+                    sum += lroundf (m[panel][i][j] * CALIBRATE_ONE) *
+                        (int64_t)gIn.linear[j][row][col];
+                }
+                sum >>= CALIBRATE_SHIFT;
+                if (gOut.linear[i][row][col] != ((sum < 0) ? 0 : (sum > 65535) ? 65535 : sum)) {
+                    off++;
+                }
+            }
+        }
+    }
+
+    if (off > 0) {
+        printf ("calibrate-matrix: FAILED, %d channels off\n", off);
+        return false;
+    }
+
+    printf ("calibrate-matrix: ok\n");
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// dimming -- the shift drops on the frame that needs it and only rises after DIMMING_HOLD
+// frames, and both dithers quantize a shifted frame as if it had been drawn shifted
+//
+
+static bool CheckDimmingHold (void)
+{
+    DimmingControl dimming;
+    int32_t frame, shift;
+
+    // 0x0c00 fits a shift of 4 with headroom, so the gain comes back one bit per hold
+    FlatLinear (&gIn, 0x0c00);
+    for (shift = 1; shift <= DIMMING_MAX_SHIFT; shift++) {
+        for (frame = 1; frame <= DIMMING_HOLD; frame++) {
+            int32_t expected = (frame < DIMMING_HOLD) ? shift - 1 : shift;
+            if (dimming.update (&gIn) != expected) {
+                printf ("dimming-hold: FAILED, shift %d on frame %d of the hold for %d\n",
+                    dimming.getShift (), frame, shift);
+                return false;
+            }
+        }
+    }
+
+    // one pixel at 0x4000 only fits a shift of 1, on the same frame
+    gIn.linear[1][DISPLAY_HEIGHT / 2][DISPLAY_WIDTH / 2] = 0x4000;
+    if ((dimming.update (&gIn) != 1) || (dimming.getLevel () != (DIMMING_FULL >> 1))) {
+        printf ("dimming-hold: FAILED, shift %d and level 0x%x after a bright frame\n",
+            dimming.getShift (), dimming.getLevel ());
+        return false;
+    }
+
+    // and the hold starts over once it's gone
+    gIn.linear[1][DISPLAY_HEIGHT / 2][DISPLAY_WIDTH / 2] = 0x0c00;
+    for (frame = 1; frame <= DIMMING_HOLD; frame++) {
+        if (dimming.update (&gIn) != ((frame < DIMMING_HOLD) ? 1 : 2)) {
+            printf ("dimming-hold: FAILED, shift %d on frame %d after a bright frame\n",
+                dimming.getShift (), frame);
+            return false;
+        }
+    }
+
+    printf ("dimming-hold: ok\n");
+    return true;
+}
+
+
+static bool CheckDitherShift (void)
+{
+    static LinearFrame shifted;
+    TemporalDither temporalA, temporalB;
+    OrderedDither ordered;
+    int32_t shift, frame, i, row, col;
+
+    for (shift = 1; shift <= DIMMING_MAX_SHIFT; shift++) {
+        temporalA.reset ();
+        temporalB.reset ();
+
+        for (frame = 0; frame < 8; frame++) {
+            RandomLinear (&gIn);
+            for (i = 0; i < 3; i++) {
+                for (row = 0; row < DISPLAY_HEIGHT; row++) {
+                    for (col = 0; col < DISPLAY_WIDTH; col++) {
+                        gIn.linear[i][row][col] >>= shift;
+                        shifted.linear[i][row][col] = gIn.linear[i][row][col] << shift;
+                    }
+                }
+            }
+
+            temporalA.quantize (&gIn, &gFrameA, shift);
+            temporalB.quantize (&shifted, &gFrameB);
+            if (memcmp (&gFrameA, &gFrameB, sizeof (gFrameA))) {
+                printf ("dither-shift: FAILED, temporal dither differs at shift %d frame %d\n",
+                    shift, frame);
+                return false;
+            }
+
+            ordered.quantize (&gIn, &gFrameA, shift);
+            ordered.quantize (&shifted, &gFrameB);
+            if (memcmp (&gFrameA, &gFrameB, sizeof (gFrameA))) {
+                printf ("dither-shift: FAILED, ordered dither differs at shift %d\n", shift);
+                return false;
+            }
+        }
+    }
+
+    printf ("dither-shift: ok\n");
+    return true;
+}
+
+
+// a dim ramp shown through the ordered dither, at full level and with the gain dimming picks
+static bool CheckDimmingError (void)
+{
+    DimmingControl dimming;
+    OrderedDither ordered;
+    int32_t i, row, col, frame;
+    double full, dimmed;
+
+    for (i = 0; i < 3; i++) {
+        for (row = 0; row < DISPLAY_HEIGHT; row++) {
+            for (col = 0; col < DISPLAY_WIDTH; col++) {
+                gIn.linear[i][row][col] = (row * DISPLAY_WIDTH + col) * 0x0c00 /
+                    (DISPLAY_WIDTH * DISPLAY_HEIGHT - 1);
+            }
+        }
+    }
+
+    ordered.quantize (&gIn, &gFrameA);
+    full = RmsError (&gIn, &gFrameA, 0);
+
+    for (frame = 0; frame < DIMMING_MAX_SHIFT * DIMMING_HOLD; frame++) {
+        dimming.update (&gIn);
+    }
+    ordered.quantize (&gIn, &gFrameB, dimming.getShift ());
+    dimmed = RmsError (&gIn, &gFrameB, dimming.getShift ());
+
+    if ((dimming.getShift () != DIMMING_MAX_SHIFT) || (dimmed > full / 8)) {
+        printf ("dimming-error: FAILED, rms error %.3f levels at shift %d, %.3f without\n",
+            dimmed, dimming.getShift (), full);
+        return false;
+    }
+
+    printf ("dimming-error: ok, rms error %.3f levels at shift %d, %.3f without\n", dimmed,
+        dimming.getShift (), full);
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// power -- limited frames never come out over the -a or -A budgets, frames within them
+// are passed through untouched, and without a dimming register the level is never touched
+//
+
+static bool CheckPowerBudget (void)
+{
+    int32_t frame, row, col, density, panelMa, totalMa, worst = -1000000, limited = 0;
+    uint16_t level, before;
+    const Frame *out;
+    bool useLevel;
+
+    for (frame = 0; frame < POWER_FRAMES; frame++) {
+        PowerLimit power;
+
+        // frames from mostly black to mostly lit, at any dimming level
+        density = rand () % 16;
+        for (row = 0; row < DISPLAY_HEIGHT; row++) {
+            for (col = 0; col < DISPLAY_WIDTH; col++) {
+                gFrameA.levels[row][col] = ((rand () % 16) <= density) ? rand () & 0xfff : 0;
+            }
+        }
+        panelMa = (rand () % 2) ? rand () % (POWER_PANEL_FULL_MA / 2) : 0;
+        totalMa = (rand () % 4) ? 1 + rand () % (PANELS * POWER_PANEL_FULL_MA / 4) : 0;
+        useLevel = rand () % 2;
+        level = before = rand () % (DIMMING_FULL + 1);
+
+        power.setBudget (panelMa, totalMa, useLevel);
+        out = power.limit (&gFrameA, &level);
+
+        if (((totalMa > 0) && (power.getPower () > totalMa)) ||
+                ((panelMa > 0) && (power.getPanelPeak () > panelMa)) ||
+                (power.getPower () > power.getDemand ()) || (level > before) ||
+                (!FPGA_HAS_DIMMING && (level != before))) {
+            printf ("power-budget: FAILED, frame %d at %d mA, busiest panel %d mA, "
+                "budgets %d and %d mA\n", frame, power.getPower (), power.getPanelPeak (),
+                panelMa, totalMa);
+            return false;
+        }
+
+        if (power.getPower () < power.getDemand ()) {
+            limited++;
+        } else if ((out != &gFrameA) || (level != before)) {
+            printf ("power-budget: FAILED, frame %d within budget was changed\n", frame);
+            return false;
+        }
+
+        if ((totalMa > 0) && (power.getPower () - totalMa > worst)) {
+            worst = power.getPower () - totalMa;
+        }
+    }
+
+    printf ("power-budget: ok, %d of %d frames limited, closest %d mA under the total\n",
+        limited, POWER_FRAMES, -worst);
+    return true;
+}
+
+
+static const StageCheck gChecks[] = {
+    { "hueconv-kernels",    CheckHueKernels        },
+    { "calibrate-identity", CheckCalibrateIdentity },
+    { "calibrate-gain",     CheckCalibrateGain     },
+    { "calibrate-matrix",   CheckCalibrateMatrix   },
+    { "dimming-hold",       CheckDimmingHold       },
+    { "dither-shift",       CheckDitherShift       },
+    { "dimming-error",      CheckDimmingError      },
+    { "power-budget",       CheckPowerBudget       }
+};
+
+#define NUM_CHECKS (int32_t)(sizeof (gChecks) / sizeof (gChecks[0]))
+
+
+int main (int argc, char *argv[])
+{
+    const char *selected[MAX_SELECTED];
+    int32_t numSelected = 0;
+    int32_t i, j, failures = 0;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "p:")) != -1) {
+        switch (opt) {
+            case 'p':
+                if (numSelected < MAX_SELECTED) {
+                    selected[numSelected++] = optarg;
+                }
+                break;
+            default:
+                fprintf (stderr, "usage: %s [-p check]\n", argv[0]);
+                return -1;
+        }
+    }
+
+    for (i = 0; i < NUM_CHECKS; i++) {
+
+        // skip checks not asked for
+        if (numSelected > 0) {
+            for (j = 0; j < numSelected; j++) {
+                if (!strcmp (selected[j], gChecks[i].name)) {
+                    break;
+                }
+            }
+            if (j == numSelected) {
+                continue;
+            }
+        }
+
+        srand (STAGES_SEED);
+        if (!gChecks[i].check ()) {
+            failures++;
+        }
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// helpers
+//
+
+// every channel anywhere in the 16-bit range
+static void RandomLinear (LinearFrame *linear)
+{
+    int32_t i, row, col;
+
+    for (i = 0; i < 3; i++) {
+        for (row = 0; row < DISPLAY_HEIGHT; row++) {
+            for (col = 0; col < DISPLAY_WIDTH; col++) {
+                linear->linear[i][row][col] = rand () & 0xffff;
+            }
+        }
+    }
+}
+
+
+// every channel at value
+static void FlatLinear (LinearFrame *linear, uint16_t value)
+{
+    int32_t i, row, col;
+
+    for (i = 0; i < 3; i++) {
+        for (row = 0; row < DISPLAY_HEIGHT; row++) {
+            for (col = 0; col < DISPLAY_WIDTH; col++) {
+                linear->linear[i][row][col] = value;
+            }
+        }
+    }
+}
+
+
+// every 12-bit color
+static void RandomLevels (Frame *frame)
+{
+    int32_t row, col;
+
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        for (col = 0; col < DISPLAY_WIDTH; col++) {
+            frame->levels[row][col] = rand () & 0xfff;
+        }
+    }
+}
+
+
+// root mean square difference, in full level 4-bit steps, between the light a frame shows
+// with the dimming register cut by shift bits and the linear light it was quantized from
+static double RmsError (const LinearFrame *linear, const Frame *frame, int32_t shift)
+{
+    int32_t i, row, col;
+    double shown, wanted, sum = 0;
+
+    for (i = 0; i < 3; i++) {
+        for (row = 0; row < DISPLAY_HEIGHT; row++) {
+            for (col = 0; col < DISPLAY_WIDTH; col++) {
+                shown = (double)((frame->levels[row][col] >> (8 - 4 * i)) & 0xf) /
+                    (1 << shift);
+                wanted = linear->linear[i][row][col] * 15.0 / 65535.0;
+                sum += (shown - wanted) * (shown - wanted);
+            }
+        }
+    }
+
+    return sqrt (sum / (3 * DISPLAY_HEIGHT * DISPLAY_WIDTH));
+}
+
+
+// a calibration file giving every panel the same gain and an identity matrix, written to a
+// new temporary file whose name goes in path
+static bool WriteCalibration (char *path, float gain)
+{
+    FILE *fp;
+    int fd;
+
+    strcpy (path, "/tmp/checkstagesXXXXXX");
+    fd = mkstemp (path);
+    if ((fd < 0) || ((fp = fdopen (fd, "w")) == NULL)) {
+        perror (path);
+        return false;
+    }
+
+    fprintf (fp, "# panel gain m00 m01 m02 m10 m11 m12 m20 m21 m22\n");
+    for (int32_t panel = 0; panel < PANELS; panel++) {
+        fprintf (fp, "%d %.2f 1 0 0 0 1 0 0 0 1\n", panel, gain);
+    }
+
+    fclose (fp);
+    return true;
+}
+
+
+// a row through all four converters with the current kernel, unused pixels left at zero
+static void ConvertHues (HueOutput *out, const uint32_t *hues, const uint16_t *values,
+    int32_t count)
+{
+    memset (out, 0, sizeof (*out));
+
+    ConvertHueRow (out->levels[0], hues, count);
+    ConvertHueValueRow (out->levels[1], hues, values, count);
+    ConvertHueRowLinear (out->linear[0][0], out->linear[0][1], out->linear[0][2], hues, count);
+    ConvertHueValueRowLinear (out->linear[1][0], out->linear[1][1], out->linear[1][2], hues,
+        values, count);
+}
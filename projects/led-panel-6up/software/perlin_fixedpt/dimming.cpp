@@ -0,0 +1,143 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#define DIMMING_SSE2
+#elif defined (__ARM_NEON)
+#include <arm_neon.h>
+#define DIMMING_NEON
+#endif
+
+#include "globals.h"
+#include "triplebuffer.h"
+#include "dimming.h"
+
+// channels per frame
+#define CHANNELS (3 * DISPLAY_HEIGHT * DISPLAY_WIDTH)
+
+// a frame has to fit the next shift under 7/8 of full scale before it counts towards it
+#define HEADROOM 0xe000
+
+static uint16_t Peak (const uint16_t *linear);
+
+
+//---------------------------------------------------------------------------------------------
+// constructor
+//
+
+DimmingControl::DimmingControl (void)
+{
+    reset ();
+}
+
+
+//---------------------------------------------------------------------------------------------
+// reset
+//
+
+void DimmingControl::reset (void)
+{
+    m_shift = 0;
+    m_hold = 0;
+    m_peak = 0;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// update -- drop the shift at once when the frame needs it, raise it slowly when it doesn't
+//
+
+int32_t DimmingControl::update (const LinearFrame *linear)
+{
+    m_peak = Peak (&linear->linear[0][0][0]);
+
+    while ((m_shift > 0) && (((uint32_t)m_peak << m_shift) > 0xffff)) {
+        m_shift--;
+        m_hold = 0;
+    }
+
+    if ((m_shift < DIMMING_MAX_SHIFT) && (((uint32_t)m_peak << (m_shift + 1)) <= HEADROOM)) {
+        if (++m_hold >= DIMMING_HOLD) {
+            m_shift++;
+            m_hold = 0;
+        }
+    } else {
+        m_hold = 0;
+    }
+
+    return m_shift;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// largest of all channels, SSE2 has no unsigned 16-bit max so a + sat (b - a) stands in
+//
+
+static uint16_t Peak (const uint16_t *linear)
+{
+    uint16_t peak = 0;
+    int32_t i = 0;
+
+#if defined (DIMMING_SSE2)
+    __m128i a = _mm_setzero_si128 ();
+    __m128i b = _mm_setzero_si128 ();
+    uint16_t lanes[8];
+
+    for (; i + 16 <= CHANNELS; i += 16) {
+        __m128i x = _mm_loadu_si128 ((const __m128i *)&linear[i]);
+        __m128i y = _mm_loadu_si128 ((const __m128i *)&linear[i + 8]);
+        a = _mm_add_epi16 (a, _mm_subs_epu16 (x, a));
+        b = _mm_add_epi16 (b, _mm_subs_epu16 (y, b));
+    }
+
+    _mm_storeu_si128 ((__m128i *)lanes, _mm_add_epi16 (a, _mm_subs_epu16 (b, a)));
+    for (int32_t j = 0; j < 8; j++) {
+        peak = (lanes[j] > peak) ? lanes[j] : peak;
+    }
+#elif defined (DIMMING_NEON)
+    uint16x8_t a = vdupq_n_u16 (0);
+    uint16x8_t b = vdupq_n_u16 (0);
+    uint16x4_t m;
+
+    for (; i + 16 <= CHANNELS; i += 16) {
+        a = vmaxq_u16 (a, vld1q_u16 (&linear[i]));
+        b = vmaxq_u16 (b, vld1q_u16 (&linear[i + 8]));
+    }
+
+    a = vmaxq_u16 (a, b);
+    m = vpmax_u16 (vget_low_u16 (a), vget_high_u16 (a));
+    m = vpmax_u16 (m, m);
+    m = vpmax_u16 (m, m);
+    peak = vget_lane_u16 (m, 0);
+#endif
+
+    for (; i < CHANNELS; i++) {
+        peak = (linear[i] > peak) ? linear[i] : peak;
+    }
+
+    return peak;
+}
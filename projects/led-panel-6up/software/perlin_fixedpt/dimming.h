@@ -0,0 +1,85 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#ifndef __dimming_h_
+#define __dimming_h_
+
+// Dynamic range control through the 6-up bitstream's global dimming register.
+//
+// The dimming register cuts every bit plane's on time to level / 0x100, so a frame scaled up
+// by 2^n and shown at level 0x100 >> n looks the same as the original at full level, but
+// reaches the panel with n more bits of its linear light above the quantizer's cut. Once per
+// new frame the present thread takes the peak of all three linear planes and picks the
+// largest shift that still fits it in 16 bits. Brighter content takes the gain away on the
+// same frame so nothing clips, and gain only comes back one bit at a time once the frame has
+// fit the next shift with headroom for DIMMING_HOLD frames, so content that hovers around a
+// boundary doesn't flicker between levels. The new level is written right after the FPGA
+// swaps to the first frame scaled for it. The peak is a max over 8 pixels at a time with SSE2
+// on x86 or NEON on the BeagleBone.
+
+// full brightness and the most the content is scaled up, level 0x10 keeps about 30 clocks
+// in the shortest bit plane
+#define DIMMING_FULL      0x100
+#define DIMMING_MAX_SHIFT 4
+
+// frames a dim scene has to last before it gains a bit, half a second at 50 fps
+#define DIMMING_HOLD 25
+
+class DimmingControl
+{
+    public:
+
+        // constructor
+        DimmingControl (void);
+
+        // destructor
+        ~DimmingControl (void) { }
+
+        // back to full level and no scaling
+        void reset (void);
+
+        // measure a new frame and pick its shift, returns the shift
+        int32_t update (const LinearFrame *linear);
+
+        // bits to scale linear light up by before quantizing
+        int32_t getShift (void) {
+            return m_shift;
+        }
+
+        // dimming register value that makes up for the shift
+        uint16_t getLevel (void) {
+            return DIMMING_FULL >> m_shift;
+        }
+
+        // brightest channel of the last frame measured
+        uint16_t getPeak (void) {
+            return m_peak;
+        }
+
+    private:
+
+        int32_t m_shift;
+        int32_t m_hold;
+        uint16_t m_peak;
+};
+
+#endif
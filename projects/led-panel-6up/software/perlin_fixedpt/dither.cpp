@@ -0,0 +1,224 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#define DITHER_SSE2
+#elif defined (__ARM_NEON)
+// there is no run time check, so a 32-bit ARM build takes these only with -mfpu=neon
+#include <arm_neon.h>
+#define DITHER_NEON
+#endif
+
+#include "globals.h"
+#include "triplebuffer.h"
+#include "dither.h"
+
+// full scale linear light to 15 levels in 1/4096ths: (x * SCALE) >> 16, 0xffff -> 15 << 12
+#define SCALE 61441
+
+// pixels per frame
+#define PIXELS (DISPLAY_HEIGHT * DISPLAY_WIDTH)
+
+// keep panels a whole number of Bayer tiles
+#if (PANEL_WIDTH % 4) || (PANEL_HEIGHT % 4)
+#error panel size must be a multiple of the 4x4 Bayer matrix
+#endif
+
+static const uint8_t gBayer[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 }
+};
+
+
+//---------------------------------------------------------------------------------------------
+// constructor
+//
+
+TemporalDither::TemporalDither (void)
+{
+    reset ();
+}
+
+
+//---------------------------------------------------------------------------------------------
+// reset -- start each pixel's fractions at (bayer + 0.5) / 16 of a level
+//
+
+void TemporalDither::reset (void)
+{
+    int32_t row, col;
+
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        for (col = 0; col < DISPLAY_WIDTH; col++) {
+            m_error[0][row][col] = (gBayer[row & 3][col & 3] << 8) + 0x80;
+            m_error[1][row][col] = m_error[0][row][col];
+            m_error[2][row][col] = m_error[0][row][col];
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// quantize -- add the carried fraction, output the whole levels and keep the new fraction
+//
+// The scaled value is at most 15 << 12 and the fraction below 1 << 12, so the sum fits in
+// 16 bits and the level in its top 4.
+//
+
+void TemporalDither::quantize (const LinearFrame *linear, Frame *frame, int32_t shift)
+{
+    const uint16_t *r = &linear->linear[0][0][0];
+    const uint16_t *g = &linear->linear[1][0][0];
+    const uint16_t *b = &linear->linear[2][0][0];
+    uint16_t *er = &m_error[0][0][0];
+    uint16_t *eg = &m_error[1][0][0];
+    uint16_t *eb = &m_error[2][0][0];
+    uint16_t *levels = &frame->levels[0][0];
+    int32_t i = 0;
+
+#if defined (DITHER_SSE2)
+    const __m128i scale = _mm_set1_epi16 ((int16_t)SCALE);
+    const __m128i fraction = _mm_set1_epi16 (0x0fff);
+    const __m128i count = _mm_cvtsi32_si128 (shift);
+
+    for (; i + 8 <= PIXELS; i += 8) {
+        __m128i tr = _mm_sll_epi16 (_mm_loadu_si128 ((const __m128i *)&r[i]), count);
+        __m128i tg = _mm_sll_epi16 (_mm_loadu_si128 ((const __m128i *)&g[i]), count);
+        __m128i tb = _mm_sll_epi16 (_mm_loadu_si128 ((const __m128i *)&b[i]), count);
+
+        tr = _mm_add_epi16 (_mm_mulhi_epu16 (tr, scale), _mm_loadu_si128 ((__m128i *)&er[i]));
+        tg = _mm_add_epi16 (_mm_mulhi_epu16 (tg, scale), _mm_loadu_si128 ((__m128i *)&eg[i]));
+        tb = _mm_add_epi16 (_mm_mulhi_epu16 (tb, scale), _mm_loadu_si128 ((__m128i *)&eb[i]));
+
+        _mm_storeu_si128 ((__m128i *)&er[i], _mm_and_si128 (tr, fraction));
+        _mm_storeu_si128 ((__m128i *)&eg[i], _mm_and_si128 (tg, fraction));
+        _mm_storeu_si128 ((__m128i *)&eb[i], _mm_and_si128 (tb, fraction));
+
+        __m128i out = _mm_slli_epi16 (_mm_srli_epi16 (tr, 12), 8);
+        out = _mm_or_si128 (out, _mm_slli_epi16 (_mm_srli_epi16 (tg, 12), 4));
+        out = _mm_or_si128 (out, _mm_srli_epi16 (tb, 12));
+        _mm_storeu_si128 ((__m128i *)&levels[i], out);
+    }
+#elif defined (DITHER_NEON)
+    const uint16x8_t fraction = vdupq_n_u16 (0x0fff);
+    const int16x8_t count = vdupq_n_s16 (shift);
+
+    for (; i + 8 <= PIXELS; i += 8) {
+        uint16x8_t tr, tg, tb, out;
+
+        tr = vshlq_u16 (vld1q_u16 (&r[i]), count);
+        tg = vshlq_u16 (vld1q_u16 (&g[i]), count);
+        tb = vshlq_u16 (vld1q_u16 (&b[i]), count);
+
+        // high half of the 32-bit products
+        tr = vcombine_u16 (vshrn_n_u32 (vmull_n_u16 (vget_low_u16 (tr), SCALE), 16),
+            vshrn_n_u32 (vmull_n_u16 (vget_high_u16 (tr), SCALE), 16));
+        tg = vcombine_u16 (vshrn_n_u32 (vmull_n_u16 (vget_low_u16 (tg), SCALE), 16),
+            vshrn_n_u32 (vmull_n_u16 (vget_high_u16 (tg), SCALE), 16));
+        tb = vcombine_u16 (vshrn_n_u32 (vmull_n_u16 (vget_low_u16 (tb), SCALE), 16),
+            vshrn_n_u32 (vmull_n_u16 (vget_high_u16 (tb), SCALE), 16));
+
+        tr = vaddq_u16 (tr, vld1q_u16 (&er[i]));
+        tg = vaddq_u16 (tg, vld1q_u16 (&eg[i]));
+        tb = vaddq_u16 (tb, vld1q_u16 (&eb[i]));
+
+        vst1q_u16 (&er[i], vandq_u16 (tr, fraction));
+        vst1q_u16 (&eg[i], vandq_u16 (tg, fraction));
+        vst1q_u16 (&eb[i], vandq_u16 (tb, fraction));
+
+        out = vshlq_n_u16 (vshrq_n_u16 (tr, 12), 8);
+        out = vorrq_u16 (out, vshlq_n_u16 (vshrq_n_u16 (tg, 12), 4));
+        out = vorrq_u16 (out, vshrq_n_u16 (tb, 12));
+        vst1q_u16 (&levels[i], out);
+    }
+#endif
+
+    for (; i < PIXELS; i++) {
+        uint32_t tr = ((((uint32_t)r[i] << shift) * SCALE) >> 16) + er[i];
+        uint32_t tg = ((((uint32_t)g[i] << shift) * SCALE) >> 16) + eg[i];
+        uint32_t tb = ((((uint32_t)b[i] << shift) * SCALE) >> 16) + eb[i];
+
+        er[i] = tr & 0x0fff;
+        eg[i] = tg & 0x0fff;
+        eb[i] = tb & 0x0fff;
+
+        levels[i] = ((tr >> 12) << 8) | ((tg >> 12) << 4) | (tb >> 12);
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// constructor -- fold each Bayer threshold into a table of levels
+//
+// Entry i covers values i << 8 to (i << 8) + 255, taken at its middle. The level is rounded
+// up once the fraction left over passes the position's threshold, (bayer + 0.5) / 16.
+//
+
+OrderedDither::OrderedDither (void)
+{
+    int32_t row, col, i, level;
+    float value;
+
+    for (row = 0; row < 4; row++) {
+        for (col = 0; col < 4; col++) {
+            for (i = 0; i < 256; i++) {
+                value = ((i << 8) + 128) * 15.0 / 65535.0;
+                level = value + (gBayer[row][col] + 0.5) / 16.0;
+                m_lut[row][col][i] = (level > 15) ? 15 : level;
+            }
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// quantize -- one lookup per channel in the table for the pixel's matrix position
+//
+
+void OrderedDither::quantize (const LinearFrame *linear, Frame *frame, int32_t shift)
+{
+    int32_t row, col, k;
+
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        const uint16_t *r = linear->linear[0][row];
+        const uint16_t *g = linear->linear[1][row];
+        const uint16_t *b = linear->linear[2][row];
+        uint16_t *levels = frame->levels[row];
+
+        // a row uses the same four tables over and over
+        for (col = 0; col < DISPLAY_WIDTH; col += 4) {
+            for (k = 0; k < 4; k++) {
+                const uint8_t *lut = m_lut[row & 3][k];
+                levels[col + k] = (lut[(r[col + k] << shift) >> 8] << 8) |
+                    (lut[(g[col + k] << shift) >> 8] << 4) | lut[(b[col + k] << shift) >> 8];
+            }
+        }
+    }
+}
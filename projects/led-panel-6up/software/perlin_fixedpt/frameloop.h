@@ -0,0 +1,126 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#ifndef __frameloop_h_
+#define __frameloop_h_
+
+// what the render loop does after missing one or more frame deadlines
+//   FRAME_LOOP_CATCH_UP = render the missed frames back to back, up to maxCatchUp of them,
+//                         so the animation keeps its speed and only the display skips
+//   FRAME_LOOP_DROP     = render one frame and continue from the next deadline, so the
+//                         animation slows down instead
+enum FrameLoopPolicy {
+    FRAME_LOOP_CATCH_UP,
+    FRAME_LOOP_DROP
+};
+
+// how the present thread turns rendered frames into panel levels
+//   QUANTIZE_NONE     = the pattern draws 12-bit gLevels, uploaded as they are
+//   QUANTIZE_TEMPORAL = the pattern draws 16-bit gLinear, dithered over time to 4 bits per
+//                       channel and uploaded every frame period even when nothing new was
+//                       rendered, see dither.h
+//   QUANTIZE_ORDERED  = the pattern draws 16-bit gLinear, ordered dithered to 4 bits per
+//                       channel with a Bayer matrix, uploaded when a new frame is rendered
+//   QUANTIZE_PALETTE  = the pattern draws gIndices and gPalette, mapped to levels when a new
+//                       frame is rendered, see palette.h
+enum QuantizeMode {
+    QUANTIZE_NONE,
+    QUANTIZE_TEMPORAL,
+    QUANTIZE_ORDERED,
+    QUANTIZE_PALETTE,
+    QUANTIZE_MODES
+};
+
+// frame loop settings shared by the render and present threads
+typedef struct {
+    int32_t fps;                // frames per second
+    FrameLoopPolicy policy;     // missed deadline policy
+    int32_t maxCatchUp;         // most frames rendered back to back when catching up
+    int32_t priority;           // SCHED_FIFO priority for the render thread, 0 = SCHED_OTHER
+                                // the present thread runs one level above it
+    int32_t cpu;                // cpu to pin both threads to, -1 = any
+    const char *statsSocket;    // Unix socket to serve stats on, NULL = none
+    int32_t testPin;            // StatsStage to show on the FPGA test pin, -1 = none
+    QuantizeMode quantize;      // how gLevels are made
+    const char *calibration;    // per panel color correction file, NULL = none
+    bool dimming;               // scale dim linear frames up and the panels down to match
+    int32_t panelBudget;        // most supply current for any one panel in mA, 0 = no limit
+    int32_t totalBudget;        // most supply current for all panels in mA, 0 = no limit
+    int32_t threads;            // threads to render banded patterns on, counting the render
+                                // thread, the others run unpinned at normal priority
+} FrameLoopConfig;
+
+// fill in the defaults: 50 fps, catch up at most 5 frames, normal priority, any cpu,
+// no stats socket, test pin unused, patterns draw gLevels, no color correction, no dimming,
+// no current limits, render on one thread
+void FrameLoopDefaults (FrameLoopConfig *config);
+
+// override the defaults from the command line, returns false and prints usage on error
+//   -f fps   -p priority   -c cpu   -d (drop missed frames instead of catching up)
+//   -s stats socket path   -t test pin stage (0 = render, 1 = upload, 2 = swap, 3 = quantize)
+//   -q quantizer (0 = none, 1 = temporal dither, 2 = ordered dither, 3 = palette)
+//   -m color calibration file, see calibrate.h
+//   -g (dynamic range control through the dimming register, needs -q 1 or 2 and a board
+//       built with FPGA_HAS_DIMMING, see dimming.h)
+//   -a panel current budget in mA   -A total current budget in mA, see power.h
+//   -j threads to render on, see tiles.h
+bool FrameLoopParseArgs (int argc, char *argv[], FrameLoopConfig *config);
+
+// apply the scheduling priority and cpu affinity to the calling thread
+void FrameLoopSetThread (const FrameLoopConfig *config, int32_t priority);
+
+// periodic deadlines on the monotonic clock
+//
+// Deadlines are absolute, kept as multiples of the period from the start time, so sleeping
+// late or taking a long frame never shifts the schedule the way a relative timer does.
+
+class FrameClock
+{
+    public:
+
+        // constructor
+        FrameClock (int32_t fps);
+
+        // destructor
+        ~FrameClock (void) { }
+
+        // make the first deadline one period from now
+        void start (void);
+
+        // sleep until the next deadline, returns the number of deadlines that passed since
+        // the previous call: 1 when on time, more when the caller overran its frame
+        int32_t wait (void);
+
+        // get period in nanoseconds
+        int64_t getPeriod (void) {
+            return m_period;
+        }
+
+        // current time on the monotonic clock in nanoseconds
+        static int64_t now (void);
+
+    private:
+
+        int64_t m_period;
+        int64_t m_next;
+};
+
+#endif
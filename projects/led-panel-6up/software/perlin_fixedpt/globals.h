@@ -22,9 +22,36 @@
 #ifndef __globals_h_
 #define __globals_h_
 
+// display size, the benchmarks override it to build for other canvases
+#ifndef DISPLAY_WIDTH
 #define DISPLAY_WIDTH  96
 #define DISPLAY_HEIGHT 64
+#endif
+
+// the display is tiled with panels of this size
+#define PANEL_WIDTH  32
+#define PANEL_HEIGHT 32
+
+// FPGA frame buffer layout: start of each ping pong buffer and address step between rows
+#define PANEL_BUFFER0_BASE 0x0000
+#define PANEL_BUFFER1_BASE 0x2000
+#define PANEL_ROW_STRIDE   0x0080
+
+// the 6-up bitstream has the dimming register, beagle01.v doesn't, see FPGA_PANEL_DIMMING_REG
+#define FPGA_HAS_DIMMING 1
 
 extern uint16_t gLevels[DISPLAY_HEIGHT][DISPLAY_WIDTH];
 
+// red, green and blue planes in 16-bit linear light, 0xffff = full on, for patterns drawing
+// at more than the panel's 4 bits per channel, the pipeline quantizes them to gLevels
+extern uint16_t gLinear[3][DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+// 8-bit palette indices and the 12-bit colors they stand for, for patterns whose colors only
+// cycle from frame to frame, the pipeline shows each index as
+// gPalette[(index + gPaletteRotate) % PALETTE_SIZE]
+#define PALETTE_SIZE 256
+extern uint8_t gIndices[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+extern uint16_t gPalette[PALETTE_SIZE];
+extern int32_t gPaletteRotate;
+
 #endif
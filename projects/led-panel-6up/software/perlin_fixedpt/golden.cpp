@@ -0,0 +1,240 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "globals.h"
+#include "pattern.h"
+#include "palette.h"
+#include "tiles.h"
+#include "golden.h"
+
+#define MAX_SELECTED 16
+#define MAX_PATH 256
+
+// seed for patterns that use rand ()
+#define GOLDEN_SEED 1
+
+static bool CheckPattern (const GoldenPattern *pattern, const char *dir, int32_t tolerance,
+    bool update, bool verbose);
+static int32_t CompareFrame (const uint16_t *golden, int32_t tolerance, int32_t *maxDiff);
+static int32_t ChannelDiff (uint16_t a, uint16_t b);
+
+
+//---------------------------------------------------------------------------------------------
+// check or update the selected patterns
+//
+
+int GoldenMain (int argc, char *argv[], const GoldenPattern *patterns, int32_t count)
+{
+    const char *selected[MAX_SELECTED];
+    int32_t numSelected = 0;
+    const char *dir = "golden";
+    int32_t tolerance = -1;
+    bool update = false;
+    bool verbose = false;
+    bool usage = false;
+    int32_t threads = 1;
+    int32_t i, j, failures = 0;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "d:p:t:uvj:")) != -1) {
+        switch (opt) {
+            case 'd': dir = optarg; break;
+            case 'p':
+                if (numSelected < MAX_SELECTED) {
+                    selected[numSelected++] = optarg;
+                }
+                break;
+            case 't': tolerance = atoi (optarg); break;
+            case 'u': update = true; break;
+            case 'v': verbose = true; break;
+            case 'j': threads = atoi (optarg); break;
+            default: usage = true; break;
+        }
+    }
+
+    if (usage || (threads < 1) || (threads > TILES_MAX_THREADS)) {
+        fprintf (stderr, "usage: %s [-d golden dir] [-p pattern] [-t tolerance] [-u] [-v] "
+            "[-j threads]\n", argv[0]);
+        return -1;
+    }
+
+    if (!TilesStart (threads)) {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+
+        // skip patterns not asked for
+        if (numSelected > 0) {
+            for (j = 0; j < numSelected; j++) {
+                if (!strcmp (selected[j], patterns[i].name)) {
+                    break;
+                }
+            }
+            if (j == numSelected) {
+                continue;
+            }
+        }
+
+        if (!CheckPattern (&patterns[i], dir,
+                (tolerance >= 0) ? tolerance : patterns[i].tolerance, update, verbose)) {
+            failures++;
+        }
+    }
+
+    TilesStop ();
+
+    return (failures == 0) ? 0 : 1;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// run one pattern and compare or store its frames
+//
+
+static bool CheckPattern (const GoldenPattern *pattern, const char *dir, int32_t tolerance,
+    bool update, bool verbose)
+{
+    static uint16_t golden[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+    char path[MAX_PATH];
+    int32_t frame, differ, maxDiff, worst = 0, failed = 0;
+    FILE *fp;
+
+    snprintf (path, sizeof (path), "%s/%s.raw", dir, pattern->golden);
+    fp = fopen (path, update ? "wb" : "rb");
+    if (fp == NULL) {
+        perror (path);
+        return false;
+    }
+
+    memset (gLevels, 0, sizeof (gLevels));
+    srand (GOLDEN_SEED);
+
+    Pattern *p = pattern->create ();
+    p->init ();
+
+    for (frame = 1; frame <= GOLDEN_FRAMES; frame++) {
+        p->next ();
+
+        // indexed patterns are checked by the levels the pipeline would map them to
+        if (p->isIndexed ()) {
+            PaletteMap (&gIndices[0][0], gPalette, gPaletteRotate, &gLevels[0][0]);
+        }
+
+        if ((frame % GOLDEN_INTERVAL) != 0) {
+            continue;
+        }
+
+        if (update) {
+            fwrite (gLevels, sizeof (gLevels), 1, fp);
+            continue;
+        }
+
+        if (fread (golden, sizeof (golden), 1, fp) != 1) {
+            fprintf (stderr, "%s: %s is short or a different display size\n",
+                pattern->name, path);
+            failed++;
+            break;
+        }
+
+        differ = CompareFrame (&golden[0][0], tolerance, &maxDiff);
+        if (maxDiff > worst) {
+            worst = maxDiff;
+        }
+        if (differ > 0) {
+            failed++;
+            if (verbose) {
+                printf ("%s: frame %d, %d pixels off by up to %d\n", pattern->name, frame,
+                    differ, maxDiff);
+            }
+        }
+    }
+
+    delete p;
+
+    if (update) {
+        printf ("%s: wrote %s\n", pattern->name, path);
+    } else if ((failed == 0) && (fread (golden, 1, 1, fp) == 1)) {
+        fprintf (stderr, "%s: %s is longer than expected\n", pattern->name, path);
+        failed++;
+    }
+
+    fclose (fp);
+
+    if (!update) {
+        printf ("%s: %s, largest difference %d, tolerance %d\n", pattern->name,
+            (failed == 0) ? "ok" : "FAILED", worst, tolerance);
+    }
+
+    return failed == 0;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// count the pixels of gLevels further than tolerance from golden
+//
+
+static int32_t CompareFrame (const uint16_t *golden, int32_t tolerance, int32_t *maxDiff)
+{
+    int32_t row, col, diff, differ = 0;
+
+    *maxDiff = 0;
+
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        for (col = 0; col < DISPLAY_WIDTH; col++) {
+            diff = ChannelDiff (gLevels[row][col], golden[row * DISPLAY_WIDTH + col]);
+            if (diff > *maxDiff) {
+                *maxDiff = diff;
+            }
+            if (diff > tolerance) {
+                differ++;
+            }
+        }
+    }
+
+    return differ;
+}
+
+
+// largest difference between the red, green or blue levels of two pixels
+static int32_t ChannelDiff (uint16_t a, uint16_t b)
+{
+    int32_t shift, diff, maxDiff = 0;
+
+    for (shift = 0; shift <= 8; shift += 4) {
+        diff = (int32_t)((a >> shift) & 0xf) - (int32_t)((b >> shift) & 0xf);
+        if (diff < 0) {
+            diff = -diff;
+        }
+        if (diff > maxDiff) {
+            maxDiff = diff;
+        }
+    }
+
+    return maxDiff;
+}
@@ -0,0 +1,59 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#ifndef __golden_h_
+#define __golden_h_
+
+// Golden frame regression check.
+//
+// Each pattern is created with fixed settings, rand () is seeded with a fixed value, and
+// the pattern is run for GOLDEN_FRAMES frames. Every GOLDEN_INTERVAL frames gLevels is
+// compared with the frame stored in golden/<name>.raw, raw 16-bit levels row by row, one
+// frame after another. A pixel matches when each of its 4-bit red, green and blue levels is
+// within the tolerance of the golden one. Patterns default to an exact match; the float
+// and fixed point variants of the same pattern can be checked against each other by giving
+// them the same golden name and a tolerance. Patterns set to draw palette indices are
+// mapped through their palette into gLevels first, so they can share the golden frames of
+// the same pattern drawing colors. With -j the patterns that draw in bands spread them over
+// that many threads, and must still match exactly.
+
+// frames run and frames stored per pattern
+#define GOLDEN_FRAMES   128
+#define GOLDEN_INTERVAL 16
+
+// creates a pattern at DISPLAY_WIDTH x DISPLAY_HEIGHT
+typedef Pattern *(*GoldenFactory) (void);
+
+typedef struct {
+    const char *name;           // test name
+    const char *golden;         // golden file name without directory or .raw
+    GoldenFactory create;
+    int32_t tolerance;          // largest per channel difference that still matches
+} GoldenPattern;
+
+// check, or with -u rewrite, the golden frames of the patterns selected on the command line
+//   -d golden directory   -p pattern name   -t tolerance for every pattern   -u   -v
+//   -j threads
+// returns 0 if every pattern matched
+int GoldenMain (int argc, char *argv[], const GoldenPattern *patterns, int32_t count);
+
+#endif
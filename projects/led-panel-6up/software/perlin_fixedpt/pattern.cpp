@@ -26,51 +26,175 @@
 #include "globals.h"
 #include "gammalut.h"
 #include "pattern.h"
+#include "hueconv.h"
+#include "tiles.h"
 
 #define MAKE_COLOR(r,g,b) (((r)&0xf)<<8)+(((g)&0xf)<<4)+((b)&0xf)
 
+uint16_t gHueLut[HUE_STEPS];
+uint16_t gHueValueLut[VALUE_STEPS][HUE_STEPS];
+uint16_t gHueLinear[3][HUE_STEPS + 1];
+uint16_t gValueLinear[VALUE_STEPS];
+
+static void HueToRgb (int32_t hue, uint8_t &r, uint8_t &g, uint8_t &b);
+
+
 //---------------------------------------------------------------------------------------------
-// convert a hue from 0 to 95 to its 12-bit RGB color
+// build the color tables before main runs
 //
-// hue: 0 = red, 32 = blue, 64 = green
+// translateHue and translateHueValue used to do this math for every pixel. The tables hold
+// exactly what they computed, with the brightness rounded to the nearest 1/256.
 //
 
-uint16_t Pattern::translateHue (int32_t hue)
+static class ColorTables
 {
-    uint8_t hi, lo;
-    uint8_t r, g, b;
+    public:
+        ColorTables (void);
+} gColorTables;
 
-    hi = hue >> 4;
-    lo = ((hue & 0xf) << 4) | (hue & 0xf);
 
-    switch (hi) {
-        case 0: r = 0xff;    g = 0;       b = lo;      break;
-        case 1: r = 0xff-lo, g = 0,       b = 0xff;    break;
-        case 2: r = 0,       g = lo,      b = 0xff;    break;
-        case 3: r = 0,       g = 0xff,    b = 0xff-lo; break;
-        case 4: r = lo,      g = 0xff,    b = 0;       break;
-        case 5: r = 0xff,    g = 0xff-lo, b = 0;       break;
+ColorTables::ColorTables (void)
+{
+    uint8_t r, g, b, vr, vg, vb;
+    int32_t hue, value;
+
+    for (hue = 0; hue < HUE_STEPS; hue++) {
+        HueToRgb (hue, r, g, b);
+
+        gHueLut[hue] = MAKE_COLOR (gammaLut[r], gammaLut[g], gammaLut[b]);
+
+        for (value = 0; value < VALUE_STEPS; value++) {
+            float v = (float)value / VALUE_ONE;
+            vr = ((float)r + 0.5) * v;
+            vg = ((float)g + 0.5) * v;
+            vb = ((float)b + 0.5) * v;
+            gHueValueLut[value][hue] = MAKE_COLOR (gammaLut[vr], gammaLut[vg], gammaLut[vb]);
+        }
+
+        gHueLinear[0][hue] = gammaLinear[r];
+        gHueLinear[1][hue] = gammaLinear[g];
+        gHueLinear[2][hue] = gammaLinear[b];
     }
 
-    r = gammaLut[r];
-    g = gammaLut[g];
-    b = gammaLut[b];
+    for (int32_t i = 0; i < 3; i++) {
+        gHueLinear[i][HUE_STEPS] = gHueLinear[i][0];
+    }
 
-    return MAKE_COLOR (r,g,b);
+    // (c * v)^gamma = c^gamma * v^gamma, so brightness is a scale factor in linear light
+    for (value = 0; value < VALUE_STEPS; value++) {
+        gValueLinear[value] = GammaPow ((double)value / VALUE_ONE, GAMMA) * 65535.0 + 0.5;
+    }
 }
 
 
 //---------------------------------------------------------------------------------------------
-// convert a hue from 0 to 95 and a brightnewss from 0 to 1.0 to its 12-bit RGB color
+// draw into gLevels or gLinear
+//
+
+void Pattern::storeHueRow (int32_t row, const uint32_t *hues)
+{
+    if (m_linear) {
+        ConvertHueRowLinear (gLinear[0][row], gLinear[1][row], gLinear[2][row], hues, m_width);
+    } else {
+        ConvertHueRow (gLevels[row], hues, m_width);
+    }
+}
+
+
+void Pattern::storeHueValueRow (int32_t row, const uint32_t *hues, const uint16_t *values)
+{
+    if (m_linear) {
+        ConvertHueValueRowLinear (gLinear[0][row], gLinear[1][row], gLinear[2][row],
+            hues, values, m_width);
+    } else {
+        ConvertHueValueRow (gLevels[row], hues, values, m_width);
+    }
+}
+
+
+void Pattern::storeHueValue (int32_t row, int32_t col, uint32_t hue, int32_t value)
+{
+    if (m_linear) {
+        for (int32_t i = 0; i < 3; i++) {
+            gLinear[i][row][col] = (HueLinear (i, hue) * (uint32_t)gValueLinear[value] +
+                0x8000) >> 16;
+        }
+    } else {
+        gLevels[row][col] = gHueValueLut[value][HueStep (hue)];
+    }
+}
+
+
+void Pattern::storeLevel (int32_t row, int32_t col, uint16_t level)
+{
+    if (m_linear) {
+        // 0x1111 * 15 = 0xffff
+        gLinear[0][row][col] = ((level >> 8) & 0xf) * 0x1111;
+        gLinear[1][row][col] = ((level >> 4) & 0xf) * 0x1111;
+        gLinear[2][row][col] = (level & 0xf) * 0x1111;
+    } else {
+        gLevels[row][col] = level;
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// hue palettes
+//
+
+void Pattern::storeHuePalette (void)
+{
+    for (int32_t i = 0; i < PALETTE_SIZE; i++) {
+        gPalette[i] = gHueLut[HueStep (i * HUE_PER_INDEX)];
+    }
+}
+
+
+void Pattern::rotateHuePalette (uint32_t hue)
+{
+    gPaletteRotate = ((hue + HUE_PER_INDEX / 2) / HUE_PER_INDEX) % PALETTE_SIZE;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// banded rendering
+//
+
+// one pass over the bands of a pattern
+struct BandPass
+{
+    Pattern *pattern;
+    int32_t pass;
+};
+
+
+void Pattern::renderBands (int32_t pass)
+{
+    BandPass job = { this, pass };
+
+    TilesRun (bandWork, &job, (m_height + TILE_ROWS - 1) / TILE_ROWS);
+}
+
+
+void Pattern::bandWork (void *arg, int32_t band)
+{
+    BandPass *job = (BandPass *)arg;
+    int32_t first = band * TILE_ROWS;
+    int32_t count = job->pattern->m_height - first;
+
+    job->pattern->renderBand (job->pass, band, first, (count > TILE_ROWS) ? TILE_ROWS : count);
+}
+
+
+//---------------------------------------------------------------------------------------------
+// convert a hue from 0 to 95 to its 8-bit RGB components before gamma
 //
 // hue: 0 = red, 32 = blue, 64 = green
-// value: 0 = off, 1.0 = 100%
 //
 
-uint16_t Pattern::translateHueValue (int32_t hue, float value)
+static void HueToRgb (int32_t hue, uint8_t &r, uint8_t &g, uint8_t &b)
 {
     uint8_t hi, lo;
-    uint8_t r, g, b;
 
     hi = hue >> 4;
     lo = ((hue & 0xf) << 4) | (hue & 0xf);
@@ -83,14 +207,4 @@ uint16_t Pattern::translateHueValue (int32_t hue, float value)
         case 4: r = lo,      g = 0xff,    b = 0;       break;
         case 5: r = 0xff,    g = 0xff-lo, b = 0;       break;
     }
-
-    r = ((float)r + 0.5) * value;
-    g = ((float)g + 0.5) * value;
-    b = ((float)b + 0.5) * value;
-
-    r = gammaLut[r];
-    g = gammaLut[g];
-    b = gammaLut[b];
-
-    return MAKE_COLOR (r,g,b);
 }
@@ -22,7 +22,47 @@
 #ifndef __pattern_h_
 #define __pattern_h_
 
-extern const uint8_t gammaLut[];
+// hues around the color wheel, 0 = red, 32 = blue, 64 = green
+#define HUE_STEPS 96
+
+// Q16 hues, HUE_ONE per step, from 0 to HUE_WHEEL - 1 once wrapped
+#define HUE_ONE   0x10000
+#define HUE_WHEEL (HUE_STEPS * HUE_ONE)
+
+// Q16 hue between neighboring entries of a hue palette
+#define HUE_PER_INDEX (HUE_WHEEL / PALETTE_SIZE)
+
+// brightness steps in Q8, 0 = off to 256 = 100%
+#define VALUE_ONE   256
+#define VALUE_STEPS (VALUE_ONE + 1)
+
+// 12-bit colors with gamma applied, built once at startup from gammaLut
+extern uint16_t gHueLut[HUE_STEPS];
+extern uint16_t gHueValueLut[VALUE_STEPS][HUE_STEPS];
+
+// the same gamma curve in 16-bit linear light: red, green and blue of each hue, and each
+// brightness as a scale factor where 0xffff = 100%. Hue HUE_STEPS repeats hue 0 so the
+// fraction of a Q16 hue past the last step blends back to red.
+extern uint16_t gHueLinear[3][HUE_STEPS + 1];
+extern uint16_t gValueLinear[VALUE_STEPS];
+
+// nearest step to a Q16 hue, for the 12-bit tables
+static inline uint32_t HueStep (uint32_t hue)
+{
+    uint32_t step = (hue + HUE_ONE / 2) >> 16;
+
+    return (step >= HUE_STEPS) ? step - HUE_STEPS : step;
+}
+
+// one plane of a Q16 hue in linear light, blended between the steps either side of it. The
+// fraction is cut to Q15 so the product fits in 32 bits.
+static inline uint16_t HueLinear (int32_t plane, uint32_t hue)
+{
+    const uint16_t *lut = &gHueLinear[plane][hue >> 16];
+    int32_t frac = (hue & 0xffff) >> 1;
+
+    return lut[0] + (((lut[1] - lut[0]) * frac + 0x4000) >> 15);
+}
 
 class Pattern
 {
@@ -30,10 +70,10 @@ class Pattern
 
         // constructor
         Pattern (const int32_t width, const int32_t height) :
-            m_width(width), m_height(height) { }
+            m_width(width), m_height(height), m_linear(false), m_indexed(false) { }
 
         // destructor
-        ~Pattern (void) { }
+        virtual ~Pattern (void) { }
 
         // reset to first frame in animation
         virtual void init (void) = 0;
@@ -46,14 +86,74 @@ class Pattern
             width = m_width; height = m_height;
         }
 
-        uint16_t translateHue (int32_t hue);
-        uint16_t translateHueValue (int32_t hue, float value);
+        // draw into gLinear instead of gLevels
+        void setLinear (bool linear) {
+            m_linear = linear;
+        }
+
+        // draw palette indices into gIndices instead, returns false for patterns that can't,
+        // see palette.h
+        bool setIndexed (bool indexed) {
+            m_indexed = indexed && canIndex ();
+            return m_indexed == indexed;
+        }
+
+        bool isIndexed (void) {
+            return m_indexed;
+        }
+
+        // convert a hue from 0 to 95 to its 12-bit color
+        uint16_t translateHue (int32_t hue) {
+            return gHueLut[hue];
+        }
+
+        // convert a hue from 0 to 95 and a brightness from 0 to VALUE_ONE to its 12-bit color
+        uint16_t translateHueValue (int32_t hue, int32_t value) {
+            return gHueValueLut[value][hue];
+        }
+
+        // same with a brightness from 0 to 1.0
+        uint16_t translateHueValue (int32_t hue, float value) {
+            return gHueValueLut[(int32_t)(value * VALUE_ONE + 0.5f)][hue];
+        }
         
     protected:
+
+        // true for patterns whose colors only cycle, so they can draw palette indices
+        virtual bool canIndex (void) {
+            return false;
+        }
+
+        // fill gPalette with hues evenly around the color wheel, index i at i * HUE_PER_INDEX,
+        // and rotate it by a Q16 hue
+        void storeHuePalette (void);
+        void rotateHuePalette (uint32_t hue);
+
+        // draw a row of Q16 hues, optionally with brightnesses, or one pixel, into gLevels
+        // or gLinear depending on setLinear. gLevels gets the nearest hue step, gLinear
+        // keeps the fraction for the quantizer to carry.
+        void storeHueRow (int32_t row, const uint32_t *hues);
+        void storeHueValueRow (int32_t row, const uint32_t *hues, const uint16_t *values);
+        void storeHueValue (int32_t row, int32_t col, uint32_t hue, int32_t value);
+
+        // draw a 12-bit color, spread to the full linear range when drawing into gLinear
+        void storeLevel (int32_t row, int32_t col, uint16_t level);
+
+        // draw the frame in bands of TILE_ROWS rows, calling renderBand for every band of
+        // the pass across the tile threads, see tiles.h. Patterns that draw in bands call
+        // this from next, once per pass, and override renderBand.
+        void renderBands (int32_t pass);
+        virtual void renderBand (int32_t pass, int32_t band, int32_t first, int32_t count) { }
+
         const int32_t m_width;
         const int32_t m_height;
+        bool m_linear;
+        bool m_indexed;
 
     private:
+
+        // calls renderBand for TilesRun
+        static void bandWork (void *arg, int32_t band);
 };
 
 #endif
@@ -0,0 +1,238 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#define POWER_SSE2
+#elif defined (__ARM_NEON)
+#include <arm_neon.h>
+#define POWER_NEON
+#endif
+
+#include "globals.h"
+#include "triplebuffer.h"
+#include "calibrate.h"
+#include "dimming.h"
+#include "power.h"
+
+// sum of all channel levels of a panel at full white
+#define FULL_SUM (3 * 15 * PANEL_WIDTH * PANEL_HEIGHT)
+
+// unscaled in 1/256ths
+#define SCALE_ONE 256
+
+// the SIMD sums work on 8 pixels of one panel row at a time, and NEON's 16-bit lanes take
+// at most 60 per 8 pixels
+#if (PANEL_WIDTH % 8) || (PANEL_WIDTH * PANEL_HEIGHT > 8192)
+#error panel rows must be a multiple of 8 pixels and panels at most 8192 pixels
+#endif
+
+static void PanelSums (const Frame *frame, uint32_t *sums);
+static int32_t Milliamps (uint32_t sum, uint16_t level);
+
+
+//---------------------------------------------------------------------------------------------
+// constructor -- no limits until budgets are set
+//
+
+PowerLimit::PowerLimit (void) :
+    m_panelMa(0), m_totalMa(0), m_useLevel(false), m_demand(0), m_power(0), m_panelPeak(0)
+{
+}
+
+
+//---------------------------------------------------------------------------------------------
+// setBudget -- without a dimming register in the bitstream the total budget always scales
+// levels, since lowering a level nothing reads would leave the frame over it
+//
+
+void PowerLimit::setBudget (int32_t panelMa, int32_t totalMa, bool useLevel)
+{
+    m_panelMa = panelMa;
+    m_totalMa = totalMa;
+    m_useLevel = useLevel && FPGA_HAS_DIMMING;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// limit -- scale each panel into its own budget, then the whole display into the total
+//
+// Estimates round up and scaled levels round down, so planning from the estimates can only
+// leave each panel under its budget. The total is the sum of the panels' estimates, each
+// rounded up by less than a mA, so it is planned with one mA per panel to spare. The
+// limited frame is measured again for the stats.
+//
+
+const Frame *PowerLimit::limit (const Frame *frame, uint16_t *level)
+{
+    int32_t scale[PANELS], panel, row, col, ma, budget, total = 0;
+    bool scaled = false;
+    uint8_t lut[16];
+
+    PanelSums (frame, m_sums);
+
+    m_demand = 0;
+    for (panel = 0; panel < PANELS; panel++) {
+        ma = Milliamps (m_sums[panel], *level);
+        m_demand += ma;
+
+        scale[panel] = SCALE_ONE;
+        if ((m_panelMa > 0) && (ma > m_panelMa)) {
+            scale[panel] = (m_panelMa * SCALE_ONE) / ma;
+            scaled = true;
+        }
+
+        total += (ma * scale[panel] + SCALE_ONE - 1) / SCALE_ONE;
+    }
+
+    if ((m_totalMa > 0) && (total > m_totalMa)) {
+        budget = (m_totalMa > PANELS) ? m_totalMa - PANELS : 0;
+        if (m_useLevel) {
+            *level = ((int64_t)*level * budget) / total;
+        } else {
+            for (panel = 0; panel < PANELS; panel++) {
+                scale[panel] = (scale[panel] * ((budget * SCALE_ONE) / total)) / SCALE_ONE;
+            }
+            scaled = true;
+        }
+    }
+
+    if (scaled) {
+        for (row = 0; row < DISPLAY_HEIGHT; row++) {
+            for (panel = 0; panel < PANELS_ACROSS; panel++) {
+                int32_t s = scale[(row / PANEL_HEIGHT) * PANELS_ACROSS + panel];
+                const uint16_t *src = &frame->levels[row][panel * PANEL_WIDTH];
+                uint16_t *dst = &m_limited.levels[row][panel * PANEL_WIDTH];
+
+                if (s == SCALE_ONE) {
+                    memcpy (dst, src, PANEL_WIDTH * sizeof (uint16_t));
+                    continue;
+                }
+
+                for (col = 0; col < 16; col++) {
+                    lut[col] = (col * s) / SCALE_ONE;
+                }
+                for (col = 0; col < PANEL_WIDTH; col++) {
+                    dst[col] = (lut[(src[col] >> 8) & 0xf] << 8) |
+                        (lut[(src[col] >> 4) & 0xf] << 4) | lut[src[col] & 0xf];
+                }
+            }
+        }
+
+        frame = &m_limited;
+        PanelSums (frame, m_sums);
+    }
+
+    m_power = 0;
+    m_panelPeak = 0;
+    for (panel = 0; panel < PANELS; panel++) {
+        ma = Milliamps (m_sums[panel], *level);
+        m_power += ma;
+        m_panelPeak = (ma > m_panelPeak) ? ma : m_panelPeak;
+    }
+
+    return frame;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// sum the red, green and blue levels of every panel
+//
+// The red and blue nibbles are masked in place and green shifted down under blue, so one
+// byte add leaves two channel sums of at most 30 per pixel, which SSE2's sum of absolute
+// differences or NEON's pairwise add and accumulate fold into wider lanes.
+//
+
+static void PanelSums (const Frame *frame, uint32_t *sums)
+{
+    int32_t across, down, row, col;
+
+    for (down = 0; down < PANELS_DOWN; down++) {
+        for (across = 0; across < PANELS_ACROSS; across++) {
+            uint32_t sum = 0;
+
+#if defined (POWER_SSE2)
+            const __m128i redBlue = _mm_set1_epi16 (0x0f0f);
+            const __m128i green = _mm_set1_epi16 (0x000f);
+            const __m128i zero = _mm_setzero_si128 ();
+            __m128i acc = _mm_setzero_si128 ();
+
+            for (row = down * PANEL_HEIGHT; row < (down + 1) * PANEL_HEIGHT; row++) {
+                const uint16_t *src = &frame->levels[row][across * PANEL_WIDTH];
+                for (col = 0; col < PANEL_WIDTH; col += 8) {
+                    __m128i x = _mm_loadu_si128 ((const __m128i *)&src[col]);
+                    __m128i bytes = _mm_add_epi8 (_mm_and_si128 (x, redBlue),
+                        _mm_and_si128 (_mm_srli_epi16 (x, 4), green));
+                    acc = _mm_add_epi64 (acc, _mm_sad_epu8 (bytes, zero));
+                }
+            }
+
+            sum = _mm_cvtsi128_si32 (acc) + _mm_cvtsi128_si32 (_mm_srli_si128 (acc, 8));
+#elif defined (POWER_NEON)
+            const uint16x8_t redBlue = vdupq_n_u16 (0x0f0f);
+            const uint16x8_t green = vdupq_n_u16 (0x000f);
+            uint16x8_t acc = vdupq_n_u16 (0);
+            uint64x2_t total;
+
+            for (row = down * PANEL_HEIGHT; row < (down + 1) * PANEL_HEIGHT; row++) {
+                const uint16_t *src = &frame->levels[row][across * PANEL_WIDTH];
+                for (col = 0; col < PANEL_WIDTH; col += 8) {
+                    uint16x8_t x = vld1q_u16 (&src[col]);
+                    uint8x16_t bytes = vaddq_u8 (vreinterpretq_u8_u16 (vandq_u16 (x, redBlue)),
+                        vreinterpretq_u8_u16 (vandq_u16 (vshrq_n_u16 (x, 4), green)));
+                    acc = vpadalq_u8 (acc, bytes);
+                }
+            }
+
+            total = vpaddlq_u32 (vpaddlq_u16 (acc));
+            sum = vgetq_lane_u64 (total, 0) + vgetq_lane_u64 (total, 1);
+#else
+            for (row = down * PANEL_HEIGHT; row < (down + 1) * PANEL_HEIGHT; row++) {
+                const uint16_t *src = &frame->levels[row][across * PANEL_WIDTH];
+                for (col = 0; col < PANEL_WIDTH; col++) {
+                    sum += ((src[col] >> 8) & 0xf) + ((src[col] >> 4) & 0xf) + (src[col] & 0xf);
+                }
+            }
+#endif
+
+            sums[down * PANELS_ACROSS + across] = sum;
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// panel draw in mA for a sum of levels shown at a dimming level, rounded up
+//
+
+static int32_t Milliamps (uint32_t sum, uint16_t level)
+{
+    const uint64_t full = (uint64_t)FULL_SUM * DIMMING_FULL;
+
+    return ((uint64_t)sum * level * POWER_PANEL_FULL_MA + full - 1) / full;
+}
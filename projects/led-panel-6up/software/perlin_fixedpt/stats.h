@@ -0,0 +1,99 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#ifndef __stats_h_
+#define __stats_h_
+
+// Frame pipeline instrumentation.
+//
+// Each timed stage feeds a histogram with power of two microsecond buckets. Histograms,
+// counters and gauges are updated with relaxed atomics from the render and present threads
+// and read without locking, so a scrape in the middle of a frame may be off by that one frame.
+// Sinks: the histograms themselves, a text dump in Prometheus exposition format served on a
+// Unix socket, and optionally the FPGA test pin, raised for the duration of one stage so it
+// can be watched on a scope.
+
+// timed stages
+enum StatsStage {
+    STATS_RENDER,               // pattern next() and handing the frame to the present thread
+    STATS_UPLOAD,               // delta encode and bus writes for one frame
+    STATS_SWAP,                 // buffer select write until the FPGA reports the swap
+    STATS_QUANTIZE,             // dithering or palette mapping a frame to levels, with -q only
+    STATS_STAGES
+};
+
+// event counters
+enum StatsCounter {
+    STATS_FRAMES_RENDERED,
+    STATS_FRAMES_PRESENTED,
+    STATS_MISSED_DEADLINES,     // render deadlines that passed while still rendering
+    STATS_DROPPED_FRAMES,       // missed deadlines that were never rendered
+    STATS_SWAP_TIMEOUTS,        // uploads that gave up waiting for the previous swap
+    STATS_BUS_WRITES,           // 16-bit register writes for frame uploads
+    STATS_POWER_LIMITED,        // uploads brought down to fit the current budgets
+    STATS_COUNTERS
+};
+
+// last value gauges
+enum StatsGauge {
+    STATS_POWER_DEMAND_MA,      // estimated supply current of the last frame as rendered
+    STATS_POWER_MA,             // and as uploaded, after current limiting
+    STATS_PANEL_POWER_MA,       // busiest panel of the last upload
+    STATS_GAUGES
+};
+
+// no stage drives the test pin
+#define STATS_TEST_PIN_OFF -1
+
+// histogram buckets, bucket n counts durations below 2^n usec, the last one everything else
+#define STATS_BUCKETS 24
+
+// start timing a stage, returns the start time in nsec and raises the test pin if routed here
+int64_t StatsBegin (StatsStage stage);
+
+// finish timing a stage started at start and lower the test pin
+void StatsEnd (StatsStage stage, int64_t start);
+
+// add a duration measured some other way
+void StatsRecord (StatsStage stage, int64_t nsec);
+
+// bump a counter
+void StatsCount (StatsCounter counter, uint32_t n);
+
+// read a counter
+uint64_t StatsGetCount (StatsCounter counter);
+
+// set and read a gauge
+void StatsSetGauge (StatsGauge gauge, int64_t value);
+int64_t StatsGetGauge (StatsGauge gauge);
+
+// route the test pin to a stage, or STATS_TEST_PIN_OFF
+void StatsSetTestPin (int32_t stage);
+
+// write every histogram, counter and gauge to fp
+void StatsPrint (FILE *fp);
+
+// serve StatsPrint to every client that connects to the Unix socket at path, which is
+// removed again when the server stops
+bool StatsStartServer (const char *path);
+void StatsStopServer (void);
+
+#endif
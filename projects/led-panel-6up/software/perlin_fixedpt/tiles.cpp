@@ -0,0 +1,246 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include "globals.h"
+#include "tiles.h"
+
+// A thread's run of bands is one 64-bit word, the pass in the top half and the end and front
+// bands in the bottom two 16-bit fields, so the owner and a thief each take a band from their
+// end with one compare and swap, and a worker still finishing an old pass can't take bands
+// from a new one.
+#define RUN(pass, front, end) (((uint64_t)(pass) << 32) | ((uint64_t)(end) << 16) | (front))
+
+// keep each run on its own cache line
+struct TileRun
+{
+    uint64_t range;
+    uint8_t pad[56];
+};
+
+static TileRun gRuns[TILES_MAX_THREADS];
+
+// workers, gWorkers[0] is unused, that's the calling thread
+static pthread_t gWorkers[TILES_MAX_THREADS];
+static int32_t gThreads = 1;
+
+// the current pass, handed to the workers under gLock
+static pthread_mutex_t gLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gStart = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t gDone = PTHREAD_COND_INITIALIZER;
+static uint32_t gPass = 0;
+static void (*gWork) (void *arg, int32_t band) = NULL;
+static void *gArg = NULL;
+static int32_t gRemaining = 0;
+static bool gStopping = false;
+
+// prototypes
+static void *TileThread (void *arg);
+static void Drain (int32_t self, uint32_t pass, void (*work) (void *, int32_t), void *arg);
+static bool Take (uint64_t *run, uint32_t pass, bool back, int32_t *band);
+
+
+//---------------------------------------------------------------------------------------------
+// start and stop the workers
+//
+
+bool TilesStart (int32_t threads)
+{
+    sigset_t block, old;
+    int32_t i;
+
+    threads = (threads < 1) ? 1 : (threads > TILES_MAX_THREADS) ? TILES_MAX_THREADS : threads;
+    gStopping = false;
+
+    // keep ctrl-c and other signals on the main thread, the workers inherit this mask
+    sigfillset (&block);
+    pthread_sigmask (SIG_BLOCK, &block, &old);
+
+    for (i = 1; i < threads; i++) {
+        if (pthread_create (&gWorkers[i], NULL, TileThread, (void *)(intptr_t)i) != 0) {
+            break;
+        }
+        gThreads = i + 1;
+    }
+
+    pthread_sigmask (SIG_SETMASK, &old, NULL);
+
+    if (gThreads < threads) {
+        fprintf (stderr, "only started %d of %d tile threads\n", gThreads, threads);
+        TilesStop ();
+        return false;
+    }
+
+    return true;
+}
+
+
+void TilesStop (void)
+{
+    pthread_mutex_lock (&gLock);
+    gStopping = true;
+    pthread_cond_broadcast (&gStart);
+    pthread_mutex_unlock (&gLock);
+
+    for (int32_t i = 1; i < gThreads; i++) {
+        pthread_join (gWorkers[i], NULL);
+    }
+    gThreads = 1;
+}
+
+
+int32_t TilesGetThreads (void)
+{
+    return gThreads;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// run one pass over the bands
+//
+// Every thread starts with an even share of the bands. The caller waits for the last band
+// rather than for the workers, a worker that wakes up late finds nothing left and goes back
+// to sleep.
+//
+
+void TilesRun (void (*work) (void *arg, int32_t band), void *arg, int32_t bands)
+{
+    int32_t t, band;
+    uint32_t pass;
+
+    if ((gThreads == 1) || (bands <= 1)) {
+        for (band = 0; band < bands; band++) {
+            work (arg, band);
+        }
+        return;
+    }
+
+    pthread_mutex_lock (&gLock);
+    pass = ++gPass;
+    gWork = work;
+    gArg = arg;
+    __atomic_store_n (&gRemaining, bands, __ATOMIC_RELAXED);
+    for (t = 0; t < gThreads; t++) {
+        __atomic_store_n (&gRuns[t].range,
+            RUN (pass, bands * t / gThreads, bands * (t + 1) / gThreads), __ATOMIC_RELEASE);
+    }
+    pthread_cond_broadcast (&gStart);
+    pthread_mutex_unlock (&gLock);
+
+    Drain (0, pass, work, arg);
+
+    pthread_mutex_lock (&gLock);
+    while (__atomic_load_n (&gRemaining, __ATOMIC_ACQUIRE) > 0) {
+        pthread_cond_wait (&gDone, &gLock);
+    }
+    pthread_mutex_unlock (&gLock);
+}
+
+
+//---------------------------------------------------------------------------------------------
+// worker thread, drains every pass it wakes up for
+//
+
+static void *TileThread (void *arg)
+{
+    const int32_t self = (intptr_t)arg;
+    void (*work) (void *, int32_t);
+    void *workArg;
+    uint32_t pass;
+
+    pthread_mutex_lock (&gLock);
+    pass = gPass;
+    while (true) {
+        while ((gPass == pass) && !gStopping) {
+            pthread_cond_wait (&gStart, &gLock);
+        }
+        if (gStopping) {
+            break;
+        }
+        pass = gPass;
+        work = gWork;
+        workArg = gArg;
+        pthread_mutex_unlock (&gLock);
+
+        Drain (self, pass, work, workArg);
+
+        pthread_mutex_lock (&gLock);
+    }
+    pthread_mutex_unlock (&gLock);
+
+    return NULL;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// run bands of the pass until there are none left, own run first, then the others' in turn
+//
+
+static void Drain (int32_t self, uint32_t pass, void (*work) (void *, int32_t), void *arg)
+{
+    int32_t i, band;
+
+    for (i = 0; i < gThreads; i++) {
+        uint64_t *run = &gRuns[(self + i) % gThreads].range;
+
+        while (Take (run, pass, i != 0, &band)) {
+            work (arg, band);
+
+            // the last band wakes the caller, the release publishes what the bands drew
+            if (__atomic_sub_fetch (&gRemaining, 1, __ATOMIC_ACQ_REL) == 0) {
+                pthread_mutex_lock (&gLock);
+                pthread_cond_signal (&gDone);
+                pthread_mutex_unlock (&gLock);
+            }
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// take a band from the front or the back of a run, false once it's empty or from another pass
+//
+
+static bool Take (uint64_t *run, uint32_t pass, bool back, int32_t *band)
+{
+    uint64_t range = __atomic_load_n (run, __ATOMIC_ACQUIRE);
+    uint32_t front, end;
+
+    do {
+        front = range & 0xffff;
+        end = (range >> 16) & 0xffff;
+        if (((range >> 32) != pass) || (front >= end)) {
+            return false;
+        }
+        *band = back ? end - 1 : front;
+    } while (!__atomic_compare_exchange_n (run, &range,
+        back ? RUN (pass, front, end - 1) : RUN (pass, front + 1, end), true,
+        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    return true;
+}
@@ -0,0 +1,108 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#ifndef __triplebuffer_h_
+#define __triplebuffer_h_
+
+// one complete frame of levels as uploaded to the FPGA
+struct Frame
+{
+    uint16_t levels[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+};
+
+// one complete frame of 16-bit linear red, green and blue waiting to be quantized
+struct LinearFrame
+{
+    uint16_t linear[3][DISPLAY_HEIGHT][DISPLAY_WIDTH];
+};
+
+// one complete frame of palette indices with the palette and rotation to show it with
+struct IndexedFrame
+{
+    uint8_t indices[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+    uint16_t palette[PALETTE_SIZE];
+    int32_t rotate;
+};
+
+// single producer / single consumer triple buffer
+//
+// The renderer owns the back frame and the presenter owns the front frame. The third frame
+// sits in the middle slot and is swapped atomically with either side, so neither thread ever
+// waits for the other and the presenter always sees the most recently published frame.
+// Each slot holds a Frame, a LinearFrame and an IndexedFrame, the pipeline uses whichever
+// the patterns draw.
+
+class TripleBuffer
+{
+    public:
+
+        // constructor
+        TripleBuffer (void);
+
+        // destructor
+        ~TripleBuffer (void) { }
+
+        // renderer: frame to fill in next
+        Frame *back (void) {
+            return &m_frames[m_back];
+        }
+
+        LinearFrame *backLinear (void) {
+            return &m_linear[m_back];
+        }
+
+        IndexedFrame *backIndexed (void) {
+            return &m_indexed[m_back];
+        }
+
+        // renderer: hand the back frame to the presenter
+        void publish (void);
+
+        // presenter: swap in the newest published frame, false if nothing new was published
+        bool acquire (void);
+
+        // presenter: frame to upload
+        Frame *front (void) {
+            return &m_frames[m_front];
+        }
+
+        LinearFrame *frontLinear (void) {
+            return &m_linear[m_front];
+        }
+
+        IndexedFrame *frontIndexed (void) {
+            return &m_indexed[m_front];
+        }
+
+    private:
+
+        // set in the middle slot when it holds a frame the presenter hasn't seen yet
+        static const int32_t FRESH = 4;
+
+        Frame m_frames[3];
+        LinearFrame m_linear[3];
+        IndexedFrame m_indexed[3];
+        int32_t m_back;
+        int32_t m_front;
+        int32_t m_middle;
+};
+
+#endif
@@ -13,36 +13,30 @@
 #include <signal.h>
 #include <memory.h>
 
-void write16 (uint16_t addr, uint16_t data);
-
-int fd = 0;
+#include "fpga.h"
 
 int main (int argc, char *argv[])
 {
     // open fpga memory device
-    fd = open ("/dev/logibone_mem", O_RDWR | O_SYNC);
+    if (!FpgaOpen ()) {
+        return -1;
+    }
 
     // set address to buffer 0
-    write16 (0x0010, 0x0000);
+    Write16 (FPGA_PANEL_ADDR_REG, 0x0000);
 
     // display buffer 0
-    write16 (0x0014, 0x0000);
+    Write16 (FPGA_PANEL_BUFFER_REG, 0x0000);
 
     // fill buffer 0 with black
     for (int row = 0; row < 32; row++) {
         for (int col = 0; col < 32; col++) {
-            write16 (0x0012, 0x0000);
+            Write16 (FPGA_PANEL_DATA_REG, 0x0000);
         }
     }
     
     // close fpga device
-    close (fd);
+    FpgaClose ();
 
     return 0;
 }
-
-
-void write16 (uint16_t addr, uint16_t data)
-{
-    pwrite (fd, &data, 2, addr);
-}
@@ -0,0 +1,309 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#define CALIBRATE_SSE2
+#elif defined (__ARM_NEON)
+#include <arm_neon.h>
+#define CALIBRATE_NEON
+#endif
+
+#include "globals.h"
+#include "triplebuffer.h"
+#include "calibrate.h"
+
+#if (DISPLAY_WIDTH % PANEL_WIDTH) || (DISPLAY_HEIGHT % PANEL_HEIGHT)
+#error display size must be a whole number of panels
+#endif
+
+static void CorrectBlock (uint16_t *const dst[3], const uint16_t *const src[3],
+    const int32_t matrix[3][3]);
+static void BuildLut (uint16_t *lut, const int32_t matrix[3][3]);
+
+
+//---------------------------------------------------------------------------------------------
+// constructor -- every panel starts uncorrected
+//
+
+PanelCalibration::PanelCalibration (void) :
+    m_loaded(false)
+{
+    for (int32_t panel = 0; panel < PANELS; panel++) {
+        for (int32_t i = 0; i < 3; i++) {
+            for (int32_t j = 0; j < 3; j++) {
+                m_matrix[panel][i][j] = (i == j) ? CALIBRATE_ONE : 0;
+            }
+        }
+        m_identity[panel] = true;
+        BuildLut (m_lut[panel], m_matrix[panel]);
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// load -- parse the file and set each panel it lists
+//
+
+bool PanelCalibration::load (const char *path)
+{
+    char line[256], *hash;
+    float gain, m[3][3];
+    int32_t panel, fields, lineNumber = 0;
+    FILE *fp;
+
+    fp = fopen (path, "r");
+    if (fp == NULL) {
+        perror (path);
+        return false;
+    }
+
+    while (fgets (line, sizeof (line), fp) != NULL) {
+        lineNumber++;
+
+        hash = strchr (line, '#');
+        if (hash != NULL) {
+            *hash = '\0';
+        }
+
+        fields = sscanf (line, "%d %f %f %f %f %f %f %f %f %f %f", &panel, &gain,
+            &m[0][0], &m[0][1], &m[0][2], &m[1][0], &m[1][1], &m[1][2],
+            &m[2][0], &m[2][1], &m[2][2]);
+
+        // blank or comment
+        if (fields <= 0) {
+            continue;
+        }
+
+        if ((fields != 11) || !set (panel, gain, m)) {
+            fprintf (stderr, "%s:%d: expected panel 0 to %d, gain and 9 matrix values, "
+                "gain times matrix within -%d to %d\n", path, lineNumber, PANELS - 1,
+                CALIBRATE_MAX, CALIBRATE_MAX);
+            fclose (fp);
+            return false;
+        }
+    }
+
+    fclose (fp);
+    m_loaded = true;
+
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// set -- fold the gain into the Q12 matrix and build the panel's table
+//
+
+bool PanelCalibration::set (int32_t panel, float gain, const float matrix[3][3])
+{
+    int32_t m[3][3], i, j;
+    bool identity = true;
+
+    if ((panel < 0) || (panel >= PANELS) || (gain < 0)) {
+        return false;
+    }
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 3; j++) {
+            float value = gain * matrix[i][j];
+            if ((value < -CALIBRATE_MAX) || (value > CALIBRATE_MAX)) {
+                return false;
+            }
+            m[i][j] = lroundf (value * CALIBRATE_ONE);
+            if (m[i][j] != ((i == j) ? CALIBRATE_ONE : 0)) {
+                identity = false;
+            }
+        }
+    }
+
+    memcpy (m_matrix[panel], m, sizeof (m));
+    m_identity[panel] = identity;
+    BuildLut (m_lut[panel], m);
+    m_loaded = true;
+
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// apply -- each panel's matrix over its block of the three planes, untouched panels copied
+//
+
+void PanelCalibration::apply (const LinearFrame *in, LinearFrame *out)
+{
+    int32_t row, panel, i;
+
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        for (panel = 0; panel < PANELS_ACROSS; panel++) {
+            int32_t index = (row / PANEL_HEIGHT) * PANELS_ACROSS + panel;
+            const uint16_t *src[3];
+            uint16_t *dst[3];
+
+            for (i = 0; i < 3; i++) {
+                src[i] = &in->linear[i][row][panel * PANEL_WIDTH];
+                dst[i] = &out->linear[i][row][panel * PANEL_WIDTH];
+            }
+
+            if (m_identity[index]) {
+                for (i = 0; i < 3; i++) {
+                    memcpy (dst[i], src[i], PANEL_WIDTH * sizeof (uint16_t));
+                }
+            } else {
+                CorrectBlock (dst, src, m_matrix[index]);
+            }
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// apply -- one table per panel, one lookup per pixel
+//
+
+void PanelCalibration::apply (const Frame *in, Frame *out)
+{
+    int32_t row, col, panel;
+
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+        for (panel = 0; panel < PANELS_ACROSS; panel++) {
+            const uint16_t *lut = m_lut[(row / PANEL_HEIGHT) * PANELS_ACROSS + panel];
+            const uint16_t *src = &in->levels[row][panel * PANEL_WIDTH];
+            uint16_t *dst = &out->levels[row][panel * PANEL_WIDTH];
+
+            for (col = 0; col < PANEL_WIDTH; col++) {
+                dst[col] = lut[src[col] & 0xfff];
+            }
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// correct one panel row in linear light, rounded to the nearest 16-bit step
+//
+// With every value within CALIBRATE_MAX a product fits in 30 bits and the sum of three in a
+// signed 32 bits. SSE2 only multiplies signed 16-bit pairs, so its inputs are flipped to
+// signed by taking 0x8000 off, which the bias puts back, and its result comes out 0x8000
+// low so the signed saturating pack clamps it to 0 to 65535. NEON widens to 32 bits and its
+// rounding narrow does the rounding and the clamp in one.
+//
+
+static void CorrectBlock (uint16_t *const dst[3], const uint16_t *const src[3],
+    const int32_t matrix[3][3])
+{
+    int32_t col = 0, i, in[3], out;
+
+#if defined (CALIBRATE_SSE2)
+    const __m128i flip = _mm_set1_epi16 ((int16_t)0x8000);
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i rg[3], bz[3], bias[3];
+
+    for (i = 0; i < 3; i++) {
+        rg[i] = _mm_set1_epi32 ((matrix[i][1] << 16) | (matrix[i][0] & 0xffff));
+        bz[i] = _mm_set1_epi32 (matrix[i][2] & 0xffff);
+        bias[i] = _mm_set1_epi32 (0x8000 * (matrix[i][0] + matrix[i][1] + matrix[i][2] -
+            CALIBRATE_ONE) + CALIBRATE_ONE / 2);
+    }
+
+    for (; col + 8 <= PANEL_WIDTH; col += 8) {
+        __m128i r = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *)&src[0][col]), flip);
+        __m128i g = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *)&src[1][col]), flip);
+        __m128i b = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *)&src[2][col]), flip);
+        __m128i rgLo = _mm_unpacklo_epi16 (r, g), rgHi = _mm_unpackhi_epi16 (r, g);
+        __m128i bLo = _mm_unpacklo_epi16 (b, zero), bHi = _mm_unpackhi_epi16 (b, zero);
+
+        for (i = 0; i < 3; i++) {
+            __m128i lo = _mm_add_epi32 (_mm_add_epi32 (_mm_madd_epi16 (rgLo, rg[i]),
+                _mm_madd_epi16 (bLo, bz[i])), bias[i]);
+            __m128i hi = _mm_add_epi32 (_mm_add_epi32 (_mm_madd_epi16 (rgHi, rg[i]),
+                _mm_madd_epi16 (bHi, bz[i])), bias[i]);
+            __m128i levels = _mm_packs_epi32 (_mm_srai_epi32 (lo, CALIBRATE_SHIFT),
+                _mm_srai_epi32 (hi, CALIBRATE_SHIFT));
+            _mm_storeu_si128 ((__m128i *)&dst[i][col], _mm_xor_si128 (levels, flip));
+        }
+    }
+#elif defined (CALIBRATE_NEON)
+    for (; col + 8 <= PANEL_WIDTH; col += 8) {
+        uint16x8_t r = vld1q_u16 (&src[0][col]);
+        uint16x8_t g = vld1q_u16 (&src[1][col]);
+        uint16x8_t b = vld1q_u16 (&src[2][col]);
+        int32x4_t rLo = vreinterpretq_s32_u32 (vmovl_u16 (vget_low_u16 (r)));
+        int32x4_t rHi = vreinterpretq_s32_u32 (vmovl_u16 (vget_high_u16 (r)));
+        int32x4_t gLo = vreinterpretq_s32_u32 (vmovl_u16 (vget_low_u16 (g)));
+        int32x4_t gHi = vreinterpretq_s32_u32 (vmovl_u16 (vget_high_u16 (g)));
+        int32x4_t bLo = vreinterpretq_s32_u32 (vmovl_u16 (vget_low_u16 (b)));
+        int32x4_t bHi = vreinterpretq_s32_u32 (vmovl_u16 (vget_high_u16 (b)));
+
+        for (i = 0; i < 3; i++) {
+            int32x4_t lo = vmulq_n_s32 (rLo, matrix[i][0]);
+            int32x4_t hi = vmulq_n_s32 (rHi, matrix[i][0]);
+            lo = vmlaq_n_s32 (vmlaq_n_s32 (lo, gLo, matrix[i][1]), bLo, matrix[i][2]);
+            hi = vmlaq_n_s32 (vmlaq_n_s32 (hi, gHi, matrix[i][1]), bHi, matrix[i][2]);
+            vst1q_u16 (&dst[i][col], vcombine_u16 (vqrshrun_n_s32 (lo, CALIBRATE_SHIFT),
+                vqrshrun_n_s32 (hi, CALIBRATE_SHIFT)));
+        }
+    }
+#endif
+
+    for (; col < PANEL_WIDTH; col++) {
+        in[0] = src[0][col];
+        in[1] = src[1][col];
+        in[2] = src[2][col];
+
+        for (i = 0; i < 3; i++) {
+            out = (matrix[i][0] * in[0] + matrix[i][1] * in[1] + matrix[i][2] * in[2] +
+                CALIBRATE_ONE / 2) >> CALIBRATE_SHIFT;
+            dst[i][col] = (out < 0) ? 0 : (out > 65535) ? 65535 : out;
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// correct each 12-bit color the same way and round it back to 4 bits per channel
+//
+
+static void BuildLut (uint16_t *lut, const int32_t matrix[3][3])
+{
+    int32_t color, i, in[3], out[3];
+
+    for (color = 0; color < 4096; color++) {
+        in[0] = (color >> 8) & 0xf;
+        in[1] = (color >> 4) & 0xf;
+        in[2] = color & 0xf;
+
+        for (i = 0; i < 3; i++) {
+            out[i] = (matrix[i][0] * in[0] + matrix[i][1] * in[1] + matrix[i][2] * in[2] +
+                CALIBRATE_ONE / 2) >> CALIBRATE_SHIFT;
+            out[i] = (out[i] < 0) ? 0 : (out[i] > 15) ? 15 : out[i];
+        }
+
+        lut[color] = (out[0] << 8) | (out[1] << 4) | out[2];
+    }
+}
@@ -0,0 +1,155 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+#include "globals.h"
+#include "pattern.h"
+#include "tiles.h"
+#include "circle.h"
+#include "perlin.h"
+#include "wash.h"
+#include "twinkle.h"
+#include "wipe.h"
+#include "golden.h"
+
+// levels the patterns draw into, compared with the golden frames
+uint16_t gLevels[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+// linear light, for patterns set to draw it
+uint16_t gLinear[3][DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+// palette indices, for patterns set to draw them
+uint8_t gIndices[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+uint16_t gPalette[PALETTE_SIZE];
+int32_t gPaletteRotate = 0;
+
+
+//---------------------------------------------------------------------------------------------
+// patterns with the same settings as their run programs
+//
+
+static Pattern *CreateCircle (void)
+{
+    return new Circle (DISPLAY_WIDTH, DISPLAY_HEIGHT,
+        (DISPLAY_WIDTH - 1.0) / 2.0 -4, (DISPLAY_HEIGHT - 1.0) / 2.0 + 4,
+        1.0, 0.75);
+}
+
+
+static Pattern *NewPerlin (PerlinNumeric numeric)
+{
+    Perlin *pattern = new Perlin (DISPLAY_WIDTH, DISPLAY_HEIGHT,
+        2, 8.0/64.0, 0.0125, 512.0, 0.005);
+    pattern->setNumeric (numeric);
+    return pattern;
+}
+
+
+static Pattern *CreatePerlin (void)
+{
+    return NewPerlin (PERLIN_FLOAT);
+}
+
+
+static Pattern *CreatePerlinLoop (void)
+{
+    Perlin *pattern = new Perlin (DISPLAY_WIDTH, DISPLAY_HEIGHT, 1, 8.0/64.0, 0.0125, 1.0, 0.2);
+    pattern->setNumeric (PERLIN_FLOAT);
+    pattern->setLoop (true);
+    return pattern;
+}
+
+
+// the same noise worked out in fixed point, checked against the float frames, the noise
+// rounds differently so colors can come out a few levels off
+static Pattern *CreatePerlinQ8 (void)
+{
+    return NewPerlin (PERLIN_Q8_8);
+}
+
+
+static Pattern *CreatePerlinQ16 (void)
+{
+    return NewPerlin (PERLIN_Q16_16);
+}
+
+
+static Pattern *CreateWash (void)
+{
+    return new Wash (DISPLAY_WIDTH, DISPLAY_HEIGHT, 1.0, 1.0, 0);
+}
+
+
+static Pattern *CreateTwinkle (void)
+{
+    return new Twinkle (DISPLAY_WIDTH, DISPLAY_HEIGHT);
+}
+
+
+static Pattern *CreateWipe (void)
+{
+    return new Wipe (DISPLAY_WIDTH, DISPLAY_HEIGHT, 0, 2);
+}
+
+
+// the same patterns drawing palette indices, hues land on the nearest of 256 palette
+// entries before the nearest of the 96 hue steps, so they can come out one step off
+static Pattern *CreateCircleIndexed (void)
+{
+    Pattern *pattern = CreateCircle ();
+    pattern->setIndexed (true);
+    return pattern;
+}
+
+
+static Pattern *CreateWashIndexed (void)
+{
+    Pattern *pattern = CreateWash ();
+    pattern->setIndexed (true);
+    return pattern;
+}
+
+
+static const GoldenPattern gPatterns[] = {
+    { "circle",         "circle",      CreateCircle,        0 },
+    { "perlin",         "perlin",      CreatePerlin,        0 },
+    { "perlin-loop",    "perlin-loop", CreatePerlinLoop,    0 },
+    { "perlin-q8.8",    "perlin",      CreatePerlinQ8,      3 },
+    { "perlin-q16.16",  "perlin",      CreatePerlinQ16,     3 },
+    { "wash",           "wash",        CreateWash,          0 },
+    { "twinkle",        "twinkle",     CreateTwinkle,       0 },
+    { "wipe",           "wipe",        CreateWipe,          0 },
+    { "circle-indexed", "circle",      CreateCircleIndexed, 3 },
+    { "wash-indexed",   "wash",        CreateWashIndexed,   3 }
+};
+
+
+int main (int argc, char *argv[])
+{
+    return GoldenMain (argc, argv, gPatterns, sizeof (gPatterns) / sizeof (gPatterns[0]));
+}
@@ -42,7 +42,7 @@ Circle::Circle
 ) : 
     Pattern (width, height), 
     m_center_x((width-1.0)/2.0), m_center_y((height-1.0)/2.0),
-    m_speed(1.0), m_scale(1.0)
+    m_speed(1.0), m_scale(1.0), m_drawn(false)
 {
     calculateDistanceLut ();
 }
@@ -56,7 +56,7 @@ Circle::Circle
 ) : 
     Pattern (width, height), 
     m_center_x(center_x), m_center_y(center_y),
-    m_speed(speed), m_scale(scale)
+    m_speed(speed), m_scale(scale), m_drawn(false)
 {
     calculateDistanceLut ();
 }
@@ -78,6 +78,7 @@ Circle::~Circle (void)
 void Circle::init (void)
 {
     m_state = 0;
+    m_drawn = false;
 }
 
 
@@ -88,14 +89,41 @@ void Circle::init (void)
 bool Circle::next (void)
 {
     int32_t row, col, distance, hue;
-
-    for (row = 0; row < m_height; row++) {
-        for (col = 0; col < m_width; col++) {
-            distance = m_scale * 96.0 * m_distance_lut[col][row];
-            hue = m_state - distance;
-            while (hue < 0) hue += 96;
-            while (hue >= 96) hue -= 96;
-            gLevels[row][col] = translateHue (hue);
+    uint32_t hues[DISPLAY_WIDTH];
+
+    if (m_indexed) {
+        // draw each pixel's offset from m_state once, then only turn the palette
+        if (!m_drawn) {
+            for (row = 0; row < m_height; row++) {
+                for (col = 0; col < m_width; col++) {
+                    hue = -(int32_t)(m_scale * (double)HUE_STEPS * m_distance_lut[col][row]) *
+                        HUE_ONE;
+                    while (hue < 0) hue += HUE_WHEEL;
+                    gIndices[row][col] = ((hue + HUE_PER_INDEX / 2) / HUE_PER_INDEX) %
+                        PALETTE_SIZE;
+                }
+            }
+            storeHuePalette ();
+            m_drawn = true;
+        }
+        rotateHuePalette (m_state * HUE_ONE);
+    } else {
+        for (row = 0; row < m_height; row++) {
+            for (col = 0; col < m_width; col++) {
+                // levels keep the whole steps the circle has always truncated to, linear
+                // light gets the fraction for the dither
+                if (m_linear) {
+                    distance = m_scale * HUE_WHEEL * m_distance_lut[col][row];
+                } else {
+                    distance = (int32_t)(m_scale * (double)HUE_STEPS *
+                        m_distance_lut[col][row]) * HUE_ONE;
+                }
+                hue = m_state * HUE_ONE - distance;
+                while (hue < 0) hue += HUE_WHEEL;
+                while (hue >= HUE_WHEEL) hue -= HUE_WHEEL;
+                hues[col] = hue;
+            }
+            storeHueRow (row, hues);
         }
     }
 
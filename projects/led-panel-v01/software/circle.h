@@ -53,6 +53,7 @@ class Circle : public Pattern
         void setCenter (const float x, const float y) {
             m_center_x = x; m_center_y = y;
             calculateDistanceLut ();
+            m_drawn = false;
         }
 
         // get / set scale of the circle
@@ -64,6 +65,7 @@ class Circle : public Pattern
         }
         void setScale (const float scale) {
             m_scale = scale;
+            m_drawn = false;
         }
 
         // get set speed
@@ -76,6 +78,13 @@ class Circle : public Pattern
             m_speed = speed;
         }
 
+    protected:
+
+        // the rings only turn around the color wheel, so they can be drawn once as indices
+        bool canIndex (void) {
+            return true;
+        }
+
     private:
 
         float m_speed;
@@ -83,6 +92,7 @@ class Circle : public Pattern
         float m_center_x;
         float m_center_y;
         float m_state;
+        bool m_drawn;
 
         void calculateDistanceLut (void);
         vector<vector<float> >  m_distance_lut;
@@ -0,0 +1,164 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "globals.h"
+#include "triplebuffer.h"
+#include "delta.h"
+
+
+//---------------------------------------------------------------------------------------------
+// constructor
+//
+
+DeltaEncoder::DeltaEncoder (void) :
+    m_writes(0)
+{
+    invalidate ();
+}
+
+
+void DeltaEncoder::invalidate (void)
+{
+    m_valid[0] = false;
+    m_valid[1] = false;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// bus writes for a full upload, the address only needs setting once per row if rows
+// aren't contiguous in the FPGA memory
+//
+
+int32_t DeltaEncoder::fullWrites (void)
+{
+    int32_t addressWrites = (PANEL_ROW_STRIDE == DISPLAY_WIDTH) ? 1 : DISPLAY_HEIGHT;
+
+    return DISPLAY_HEIGHT * DISPLAY_WIDTH + addressWrites;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// full -- one span per row covering every pixel
+//
+
+int32_t DeltaEncoder::full (int32_t buffer)
+{
+    int32_t base = (buffer == 0) ? PANEL_BUFFER0_BASE : PANEL_BUFFER1_BASE;
+
+    for (int32_t row = 0; row < DISPLAY_HEIGHT; row++) {
+        m_spans[row].address = base + PANEL_ROW_STRIDE * row;
+        m_spans[row].setAddress = (row == 0) || (PANEL_ROW_STRIDE != DISPLAY_WIDTH);
+        m_spans[row].row = row;
+        m_spans[row].col = 0;
+        m_spans[row].count = DISPLAY_WIDTH;
+    }
+
+    m_writes = fullWrites ();
+
+    return DISPLAY_HEIGHT;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// encode -- diff frame against the last frame uploaded to buffer
+//
+
+int32_t DeltaEncoder::encode (int32_t buffer, const Frame *frame)
+{
+    int32_t base, limit, spans, writes, nextAddress;
+    int32_t row, col, end;
+
+    if (!m_valid[buffer]) {
+        return full (buffer);
+    }
+
+    base = (buffer == 0) ? PANEL_BUFFER0_BASE : PANEL_BUFFER1_BASE;
+    limit = fullWrites ();
+    spans = 0;
+    writes = 0;
+    nextAddress = -1;
+
+    for (row = 0; row < DISPLAY_HEIGHT; row++) {
+
+        const uint16_t *src = frame->levels[row];
+        const uint16_t *old = m_shadow[buffer].levels[row];
+
+        col = 0;
+        while (col < DISPLAY_WIDTH) {
+
+            // skip unchanged pixels
+            if (src[col] == old[col]) {
+                col++;
+                continue;
+            }
+
+            // extend the run through changed pixels and single unchanged pixels, writing
+            // one pixel through costs the same as setting the address past it
+            end = col + 1;
+            while (end < DISPLAY_WIDTH) {
+                if (src[end] != old[end]) {
+                    end++;
+                } else if ((end + 1 < DISPLAY_WIDTH) && (src[end + 1] != old[end + 1])) {
+                    end += 2;
+                } else {
+                    break;
+                }
+            }
+
+            DeltaSpan *span = &m_spans[spans++];
+            span->address = base + PANEL_ROW_STRIDE * row + col;
+            span->setAddress = (span->address != nextAddress);
+            span->row = row;
+            span->col = col;
+            span->count = end - col;
+
+            writes += span->setAddress + span->count;
+            nextAddress = span->address + span->count;
+
+            // give up as soon as a full upload is no more expensive
+            if (writes >= limit) {
+                return full (buffer);
+            }
+
+            col = end;
+        }
+    }
+
+    m_writes = writes;
+
+    return spans;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// commit -- frame is now the contents of buffer
+//
+
+void DeltaEncoder::commit (int32_t buffer, const Frame *frame)
+{
+    memcpy (&m_shadow[buffer], frame, sizeof (Frame));
+    m_valid[buffer] = true;
+}
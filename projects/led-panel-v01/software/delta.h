@@ -0,0 +1,85 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#ifndef __delta_h_
+#define __delta_h_
+
+// one run of pixels written back to back through the auto incrementing address register
+typedef struct {
+    uint16_t address;       // FPGA address of the first pixel
+    uint8_t setAddress;     // 0 if the previous span already left the address register here
+    uint8_t row;
+    uint16_t col;
+    uint16_t count;
+} DeltaSpan;
+
+// Plans the bus writes needed to bring one of the FPGA's ping pong buffers up to date.
+//
+// The encoder remembers the last frame uploaded to each buffer and diffs the new frame
+// against it. Changed pixels become address + data runs; an unchanged gap is written through
+// when that costs no more than setting the address again. If the runs would take as many bus
+// writes as a full upload, encode returns a single span covering the whole frame instead.
+
+class DeltaEncoder
+{
+    public:
+
+        // constructor
+        DeltaEncoder (void);
+
+        // destructor
+        ~DeltaEncoder (void) { }
+
+        // forget buffer contents, the next upload to each buffer is a full frame
+        void invalidate (void);
+
+        // plan the writes for frame into buffer (0 or 1), returns the number of spans
+        int32_t encode (int32_t buffer, const Frame *frame);
+
+        // spans planned by the last encode
+        const DeltaSpan *getSpans (void) {
+            return m_spans;
+        }
+
+        // bus writes (address + data) the last encode needs
+        int32_t getWrites (void) {
+            return m_writes;
+        }
+
+        // record frame as the contents of buffer once it has been written
+        void commit (int32_t buffer, const Frame *frame);
+
+        // bus writes needed for a full frame upload
+        static int32_t fullWrites (void);
+
+    private:
+
+        int32_t full (int32_t buffer);
+
+        Frame m_shadow[2];
+        bool m_valid[2];
+
+        // worst case is every other pixel changed
+        DeltaSpan m_spans[DISPLAY_HEIGHT * (DISPLAY_WIDTH / 2 + 1)];
+        int32_t m_writes;
+};
+
+#endif
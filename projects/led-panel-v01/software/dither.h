@@ -0,0 +1,84 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#ifndef __dither_h_
+#define __dither_h_
+
+// Temporal dithering from 16-bit linear light down to the panel's 4 bits per channel.
+//
+// Each channel of each pixel keeps the fraction of a level its last output couldn't show, in
+// 1/4096ths of a level, and adds it to the next frame before rounding down. A channel that
+// sits between two levels alternates between them in proportion, so over a few frames the
+// panel shows the value the pattern drew and slow fades stop banding. The fractions start at
+// a 4x4 Bayer offset per pixel so neighbours at the same value don't flip on the same frame.
+// Integer only, 8 pixels at a time with SSE2 on x86 or NEON on the BeagleBone.
+
+class TemporalDither
+{
+    public:
+
+        // constructor
+        TemporalDither (void);
+
+        // destructor
+        ~TemporalDither (void) { }
+
+        // restart every fraction from its Bayer offset
+        void reset (void);
+
+        // quantize a linear frame to levels, carrying each fraction over to the next call,
+        // after scaling it up by shift bits, which the caller has checked won't overflow
+        void quantize (const LinearFrame *linear, Frame *frame, int32_t shift = 0);
+
+    private:
+
+        uint16_t m_error[3][DISPLAY_HEIGHT][DISPLAY_WIDTH];
+};
+
+// Ordered dithering from 16-bit linear light down to 4 bits per channel.
+//
+// A cheaper, flicker free alternative: each pixel compares its value against the threshold
+// at its place in a 4x4 Bayer matrix. The thresholds are folded into one table per matrix
+// position indexed by the top 8 bits of the value, about 17 steps per output level, so a
+// channel costs one byte lookup. Positions come from display coordinates, and the 32 pixel
+// panels are a whole number of matrix tiles, so the pattern carries on unbroken across the
+// seams between the 6-up's panels.
+
+class OrderedDither
+{
+    public:
+
+        // constructor
+        OrderedDither (void);
+
+        // destructor
+        ~OrderedDither (void) { }
+
+        // quantize a linear frame to levels, scaled up by shift bits the same way
+        void quantize (const LinearFrame *linear, Frame *frame, int32_t shift = 0);
+
+    private:
+
+        uint8_t m_lut[4][4][256];
+};
+
+#endif
@@ -0,0 +1,194 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "globals.h"
+#include "fpga.h"
+#include "fpgasim.h"
+
+// file descriptor for FPGA memory device
+static int gFd = -1;
+
+// FPGA register window when the device is memory mapped, NULL when using pwrite
+static volatile uint8_t *gRegs = NULL;
+
+// accesses go to the software model instead of the device
+static bool gSim = false;
+
+
+//---------------------------------------------------------------------------------------------
+// open the fpga memory device
+//
+// Every pwrite is a system call and WriteLevels does one per pixel, so map the register
+// window and use plain volatile stores when the driver allows it. The device is opened
+// O_SYNC so the mapping is uncached and each store becomes exactly one GPMC bus write.
+//
+
+bool FpgaOpen (FpgaAccess access)
+{
+    void *map;
+    const char *sim;
+
+    // run against the software model, optionally dumping displayed frames to a file
+    sim = getenv ("FPGA_SIM");
+    if ((access == FPGA_ACCESS_SIM) || ((access == FPGA_ACCESS_AUTO) && (sim != NULL))) {
+        if ((sim != NULL) && ((sim[0] == 0) || !strcmp (sim, "1"))) {
+            sim = NULL;
+        }
+        gSim = FpgaSimOpen (sim);
+        return gSim;
+    }
+
+    // open fpga memory device
+    gFd = open (FPGA_DEVICE, O_RDWR | O_SYNC);
+    if (gFd < 0) {
+        perror ("open " FPGA_DEVICE);
+        return false;
+    }
+
+    if (access == FPGA_ACCESS_PWRITE) {
+        return true;
+    }
+
+    // map the register window
+    map = mmap (NULL, FPGA_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, gFd, 0);
+    if (map == MAP_FAILED) {
+        if (access == FPGA_ACCESS_MMAP) {
+            perror ("mmap " FPGA_DEVICE);
+            close (gFd);
+            gFd = -1;
+            return false;
+        }
+        fprintf (stderr, "mmap " FPGA_DEVICE " failed, falling back to pwrite\n");
+        return true;
+    }
+
+    gRegs = (volatile uint8_t *)map;
+
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// close the fpga memory device
+//
+
+void FpgaClose (void)
+{
+    if (gSim) {
+        FpgaSimClose ();
+        gSim = false;
+    }
+    if (gRegs != NULL) {
+        munmap ((void *)gRegs, FPGA_MAP_SIZE);
+        gRegs = NULL;
+    }
+    if (gFd >= 0) {
+        close (gFd);
+        gFd = -1;
+    }
+}
+
+
+bool FpgaIsMapped (void)
+{
+    return gRegs != NULL;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// older bitstreams don't decode the status register and return whatever the previous read
+// left on the bus, so read a known register first and check the status reads differently
+//
+
+bool FpgaHasStatus (void)
+{
+    if (Read16 (FPGA_TEST_DEAD_REG) != 0xdead) {
+        return false;
+    }
+
+    return (Read16 (FPGA_PANEL_STATUS_REG) & ~(FPGA_PANEL_STATUS_CURRENT |
+        FPGA_PANEL_STATUS_SELECTED)) == 0;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// register reads and writes
+//
+
+uint16_t Read16 (uint16_t address)
+{
+    uint16_t data;
+
+    if (gSim) {
+        data = FpgaSimRead16 (address);
+    } else if (gRegs != NULL) {
+        data = *(volatile uint16_t *)(gRegs + address);
+    } else if (pread (gFd, &data, 2, address) != 2) {
+        data = 0xffff;
+    }
+
+    return data;
+}
+
+
+void Write16 (uint16_t address, uint16_t data)
+{
+    if (gSim) {
+        FpgaSimWrite16 (address, data);
+    } else if (gRegs != NULL) {
+        *(volatile uint16_t *)(gRegs + address) = data;
+    } else {
+        pwrite (gFd, &data, 2, address);
+    }
+}
+
+
+void WriteBurst16 (uint16_t address, const uint16_t *data, int32_t count)
+{
+    int32_t i;
+
+    if (gSim) {
+        for (i = 0; i < count; i++) {
+            FpgaSimWrite16 (address, data[i]);
+        }
+    } else if (gRegs != NULL) {
+        volatile uint16_t *reg = (volatile uint16_t *)(gRegs + address);
+        for (i = 0; i < count; i++) {
+            *reg = data[i];
+        }
+    } else {
+        // a single pwrite of count words would land at consecutive addresses
+        // instead of the same register, so the fallback stays one call per word
+        for (i = 0; i < count; i++) {
+            pwrite (gFd, &data[i], 2, address);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#ifndef __fpga_h_
+#define __fpga_h_
+
+// address register
+#define FPGA_PANEL_ADDR_REG 0x0010
+
+// data register
+#define FPGA_PANEL_DATA_REG 0x0012
+
+// buffer select register
+#define FPGA_PANEL_BUFFER_REG 0x0014
+
+// buffer status register, read only at the same address as buffer select
+// bit 0 = buffer being scanned out, bit 1 = buffer selected, changes at the end of a refresh
+#define FPGA_PANEL_STATUS_REG 0x0014
+#define FPGA_PANEL_STATUS_CURRENT  0x0001
+#define FPGA_PANEL_STATUS_SELECTED 0x0002
+
+// number of buffer swaps since reset, read only
+#define FPGA_PANEL_SWAP_COUNT_REG 0x001a
+
+// global dimming 0 to 0x100 (6-up bitstream only)
+#define FPGA_PANEL_DIMMING_REG 0x0016
+
+// test pin (6-up bitstream only)
+#define FPGA_TEST_PIN_REG 0x0018
+
+// test register, always reads 0xdead
+#define FPGA_TEST_DEAD_REG 0x0008
+
+// fpga memory device and the size of the register window mapped from it
+#define FPGA_DEVICE "/dev/logibone_mem"
+#define FPGA_MAP_SIZE 0x1000
+
+// how the registers are accessed
+//   FPGA_ACCESS_AUTO   = try mmap, fall back to pwrite if the driver can't map the device,
+//                        or use the software model if FPGA_SIM is set in the environment
+//   FPGA_ACCESS_MMAP   = volatile loads and stores into the mapped register window only
+//   FPGA_ACCESS_PWRITE = one pread / pwrite system call per register access
+//   FPGA_ACCESS_SIM    = no device, accesses go to the software model in fpgasim.h
+enum FpgaAccess {
+    FPGA_ACCESS_AUTO,
+    FPGA_ACCESS_MMAP,
+    FPGA_ACCESS_PWRITE,
+    FPGA_ACCESS_SIM
+};
+
+// open the fpga memory device, returns false on failure
+bool FpgaOpen (FpgaAccess access = FPGA_ACCESS_AUTO);
+
+// close the fpga memory device, safe to call more than once
+void FpgaClose (void);
+
+// true if register accesses go through the mapped window instead of pwrite
+bool FpgaIsMapped (void);
+
+// true if the bitstream has the buffer status and swap count registers
+bool FpgaHasStatus (void);
+
+// read a single 16-bit register
+uint16_t Read16 (uint16_t address);
+
+// write a single 16-bit register
+void Write16 (uint16_t address, uint16_t data);
+
+// write count words to the same register, used to stream pixels into the data register
+void WriteBurst16 (uint16_t address, const uint16_t *data, int32_t count);
+
+#endif
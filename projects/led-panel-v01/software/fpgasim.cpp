@@ -0,0 +1,259 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "globals.h"
+#include "fpga.h"
+#include "fpgasim.h"
+
+// frame memory covering both ping pong buffers, the address register wraps at its end
+#define SIM_MEMORY_WORDS (2 * PANEL_BUFFER1_BASE)
+
+static uint16_t gMemory[SIM_MEMORY_WORDS];
+
+// registers
+static uint16_t gAddress = 0;
+static uint16_t gBuffer = 0;
+static uint16_t gSwaps = 0;
+static uint16_t gDimming = 0x100;
+static uint16_t gTestPin = 0;
+static uint16_t gScratch[4];
+
+// the bus read register, which like the RTL's only changes on a decoded read, so any other
+// address returns whatever was read last, 0xffff after reset
+static uint16_t gReadData = 0xffff;
+
+// bus transactions, written by both pipeline threads so kept with relaxed atomics
+static FpgaSimCounts gCounts;
+
+// displayed frames are appended here if not NULL
+static FILE *gDump = NULL;
+
+static void Count (uint64_t *counter);
+static void DumpFrame (void);
+
+
+//---------------------------------------------------------------------------------------------
+// open and close
+//
+
+bool FpgaSimOpen (const char *dump)
+{
+    memset (gMemory, 0, sizeof (gMemory));
+    gAddress = 0;
+    gBuffer = 0;
+    gSwaps = 0;
+    gDimming = 0x100;
+    gTestPin = 0;
+    memset (gScratch, 0, sizeof (gScratch));
+    gReadData = 0xffff;
+    FpgaSimResetCounts ();
+
+    if (dump != NULL) {
+        gDump = fopen (dump, "ab");
+        if (gDump == NULL) {
+            perror (dump);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void FpgaSimClose (void)
+{
+    FpgaSimCounts counts;
+
+    FpgaSimGetCounts (&counts);
+    fprintf (stderr, "fpga sim: %llu address, %llu data, %llu buffer, %llu other writes, "
+        "%llu reads, %llu swaps\n",
+        (unsigned long long)counts.addressWrites, (unsigned long long)counts.dataWrites,
+        (unsigned long long)counts.bufferWrites, (unsigned long long)counts.otherWrites,
+        (unsigned long long)counts.reads, (unsigned long long)counts.swaps);
+
+    if (gDump != NULL) {
+        fclose (gDump);
+        gDump = NULL;
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// register accesses
+//
+
+uint16_t FpgaSimRead16 (uint16_t address)
+{
+    Count (&gCounts.reads);
+
+    // the reads beagle01.v decodes: scratch registers, test patterns, status and swaps
+    switch (address) {
+        case 0x0000:
+        case 0x0002:
+        case 0x0004:
+        case 0x0006:
+            gReadData = gScratch[address >> 1];
+            break;
+        case FPGA_TEST_DEAD_REG:
+            gReadData = 0xdead;
+            break;
+        case 0x000a:
+            gReadData = 0xbeef;
+            break;
+        case 0x000c:
+            gReadData = 0xcafe;
+            break;
+        case 0x000e:
+            gReadData = 0xfeed;
+            break;
+        case FPGA_PANEL_STATUS_REG:
+            // the swap has always happened already
+            gReadData = gBuffer ? (FPGA_PANEL_STATUS_CURRENT | FPGA_PANEL_STATUS_SELECTED) : 0;
+            break;
+        case FPGA_PANEL_SWAP_COUNT_REG:
+            gReadData = gSwaps;
+            break;
+    }
+
+    return gReadData;
+}
+
+
+void FpgaSimWrite16 (uint16_t address, uint16_t data)
+{
+    switch (address) {
+        case FPGA_PANEL_ADDR_REG:
+            Count (&gCounts.addressWrites);
+            gAddress = data;
+            break;
+
+        case FPGA_PANEL_DATA_REG:
+            Count (&gCounts.dataWrites);
+            gMemory[gAddress % SIM_MEMORY_WORDS] = data;
+            gAddress++;
+            break;
+
+        case FPGA_PANEL_BUFFER_REG:
+            Count (&gCounts.bufferWrites);
+            if ((data & 1) != gBuffer) {
+                gBuffer = data & 1;
+                gSwaps++;
+                Count (&gCounts.swaps);
+            }
+            DumpFrame ();
+            break;
+
+        case FPGA_PANEL_DIMMING_REG:
+            Count (&gCounts.otherWrites);
+            gDimming = data;
+            break;
+
+        case FPGA_TEST_PIN_REG:
+            Count (&gCounts.otherWrites);
+            gTestPin = data;
+            break;
+
+        case 0x0000:
+        case 0x0002:
+        case 0x0004:
+        case 0x0006:
+            Count (&gCounts.otherWrites);
+            gScratch[address >> 1] = data;
+            break;
+
+        default:
+            Count (&gCounts.otherWrites);
+            break;
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// inspect the model
+//
+
+void FpgaSimGetFrame (uint16_t levels[DISPLAY_HEIGHT][DISPLAY_WIDTH])
+{
+    int32_t base = (gBuffer == 0) ? PANEL_BUFFER0_BASE : PANEL_BUFFER1_BASE;
+
+    for (int32_t row = 0; row < DISPLAY_HEIGHT; row++) {
+        memcpy (levels[row], &gMemory[base + PANEL_ROW_STRIDE * row],
+            DISPLAY_WIDTH * sizeof (uint16_t));
+    }
+}
+
+
+void FpgaSimGetCounts (FpgaSimCounts *counts)
+{
+    counts->addressWrites = __atomic_load_n (&gCounts.addressWrites, __ATOMIC_RELAXED);
+    counts->dataWrites = __atomic_load_n (&gCounts.dataWrites, __ATOMIC_RELAXED);
+    counts->bufferWrites = __atomic_load_n (&gCounts.bufferWrites, __ATOMIC_RELAXED);
+    counts->otherWrites = __atomic_load_n (&gCounts.otherWrites, __ATOMIC_RELAXED);
+    counts->reads = __atomic_load_n (&gCounts.reads, __ATOMIC_RELAXED);
+    counts->swaps = __atomic_load_n (&gCounts.swaps, __ATOMIC_RELAXED);
+}
+
+
+void FpgaSimResetCounts (void)
+{
+    memset (&gCounts, 0, sizeof (gCounts));
+}
+
+
+uint16_t FpgaSimGetDimming (void)
+{
+    return gDimming;
+}
+
+
+uint16_t FpgaSimGetTestPin (void)
+{
+    return gTestPin;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// helpers
+//
+
+static void Count (uint64_t *counter)
+{
+    __atomic_fetch_add (counter, 1, __ATOMIC_RELAXED);
+}
+
+
+static void DumpFrame (void)
+{
+    static uint16_t levels[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+    if (gDump == NULL) {
+        return;
+    }
+
+    FpgaSimGetFrame (levels);
+    fwrite (levels, sizeof (levels), 1, gDump);
+}
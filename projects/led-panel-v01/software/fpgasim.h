@@ -0,0 +1,71 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#ifndef __fpgasim_h_
+#define __fpgasim_h_
+
+// Software model of the FPGA register map, used in place of /dev/logibone_mem to run the
+// patterns and upload code on a workstation.
+//
+// The address register points into a word addressed frame memory holding both ping pong
+// buffers at the PANEL_BUFFER0_BASE / PANEL_BUFFER1_BASE / PANEL_ROW_STRIDE layout from
+// globals.h and auto increments on every data write. A buffer select takes effect at once,
+// as if the refresh ended right after the write, and the newly displayed buffer is decoded
+// back into a DISPLAY_HEIGHT x DISPLAY_WIDTH frame. Reads return only what beagle01.v
+// decodes, anything else repeats the last decoded read. Every bus transaction is counted.
+//
+// Select it with FpgaOpen (FPGA_ACCESS_SIM), or for the existing programs by setting the
+// FPGA_SIM environment variable. FPGA_SIM=1 just runs the model, any other value names a
+// file that every displayed frame is appended to as raw 16-bit levels, row by row.
+
+// bus transaction counts since the model was opened
+typedef struct {
+    uint64_t addressWrites;     // writes to the address register
+    uint64_t dataWrites;        // writes to the data register
+    uint64_t bufferWrites;      // writes to the buffer select register
+    uint64_t otherWrites;       // dimming, test pin, scratch and undecoded writes
+    uint64_t reads;             // reads from any register
+    uint64_t swaps;             // buffer selects that changed the displayed buffer
+} FpgaSimCounts;
+
+// set up the model, dump names a file to append displayed frames to or NULL
+bool FpgaSimOpen (const char *dump);
+
+// print the transaction counts to stderr and close the dump file
+void FpgaSimClose (void);
+
+// register accesses, same addresses as the real device
+uint16_t FpgaSimRead16 (uint16_t address);
+void FpgaSimWrite16 (uint16_t address, uint16_t data);
+
+// copy the frame currently being displayed
+void FpgaSimGetFrame (uint16_t levels[DISPLAY_HEIGHT][DISPLAY_WIDTH]);
+
+// get the transaction counts, and clear them between runs
+void FpgaSimGetCounts (FpgaSimCounts *counts);
+void FpgaSimResetCounts (void);
+
+// current global dimming and test pin
+uint16_t FpgaSimGetDimming (void);
+uint16_t FpgaSimGetTestPin (void);
+
+#endif
@@ -0,0 +1,200 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "globals.h"
+#include "frameloop.h"
+#include "tiles.h"
+
+#define NSEC_PER_SEC 1000000000LL
+
+
+//---------------------------------------------------------------------------------------------
+// configuration
+//
+
+void FrameLoopDefaults (FrameLoopConfig *config)
+{
+    config->fps = 50;
+    config->policy = FRAME_LOOP_CATCH_UP;
+    config->maxCatchUp = 5;
+    config->priority = 0;
+    config->cpu = -1;
+    config->statsSocket = NULL;
+    config->testPin = -1;
+    config->quantize = QUANTIZE_NONE;
+    config->calibration = NULL;
+    config->dimming = false;
+    config->panelBudget = 0;
+    config->totalBudget = 0;
+    config->threads = 1;
+}
+
+
+bool FrameLoopParseArgs (int argc, char *argv[], FrameLoopConfig *config)
+{
+    bool usage = false;
+    int opt, quantize;
+
+    while ((opt = getopt (argc, argv, "f:p:c:ds:t:q:m:ga:A:j:")) != -1) {
+        switch (opt) {
+            case 'f': config->fps = atoi (optarg); break;
+            case 'p': config->priority = atoi (optarg); break;
+            case 'c': config->cpu = atoi (optarg); break;
+            case 'd': config->policy = FRAME_LOOP_DROP; break;
+            case 's': config->statsSocket = optarg; break;
+            case 't': config->testPin = atoi (optarg); break;
+            case 'q':
+                quantize = atoi (optarg);
+                if ((quantize < 0) || (quantize >= QUANTIZE_MODES)) {
+                    usage = true;
+                }
+                config->quantize = (QuantizeMode)quantize;
+                break;
+            case 'm': config->calibration = optarg; break;
+            case 'g': config->dimming = true; break;
+            case 'a': config->panelBudget = atoi (optarg); break;
+            case 'A': config->totalBudget = atoi (optarg); break;
+            case 'j': config->threads = atoi (optarg); break;
+            default: usage = true; break;
+        }
+    }
+
+    // dim frames only gain bits on their way down from linear light
+    if (config->dimming && (config->quantize != QUANTIZE_TEMPORAL) &&
+            (config->quantize != QUANTIZE_ORDERED)) {
+        usage = true;
+    }
+
+    // the panels can only be turned down on bitstreams with the dimming register
+    if (config->dimming && !FPGA_HAS_DIMMING) {
+        usage = true;
+    }
+
+    if ((config->panelBudget < 0) || (config->totalBudget < 0)) {
+        usage = true;
+    }
+
+    if ((config->threads < 1) || (config->threads > TILES_MAX_THREADS)) {
+        usage = true;
+    }
+
+    if ((config->fps <= 0) || (config->fps > 1000)) {
+        usage = true;
+    }
+
+    if (usage) {
+        fprintf (stderr, "usage: %s [-f fps] [-p priority] [-c cpu] [-d] "
+            "[-s stats socket] [-t test pin stage] [-q quantizer] [-m calibration] [-g] "
+            "[-a panel mA] [-A total mA] [-j threads]\n", argv[0]);
+        return false;
+    }
+
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// apply real time priority and cpu affinity to the calling thread
+//
+// Failures are reported but not fatal, running as a normal user just loses SCHED_FIFO.
+//
+
+void FrameLoopSetThread (const FrameLoopConfig *config, int32_t priority)
+{
+    struct sched_param param;
+    int err;
+
+    if (priority > 0) {
+        memset (&param, 0, sizeof (param));
+        param.sched_priority = priority;
+        err = pthread_setschedparam (pthread_self (), SCHED_FIFO, &param);
+        if (err != 0) {
+            fprintf (stderr, "SCHED_FIFO priority %d: %s\n", priority, strerror (err));
+        }
+    }
+
+    if (config->cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO (&cpus);
+        CPU_SET (config->cpu, &cpus);
+        err = pthread_setaffinity_np (pthread_self (), sizeof (cpus), &cpus);
+        if (err != 0) {
+            fprintf (stderr, "cpu affinity %d: %s\n", config->cpu, strerror (err));
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// frame clock
+//
+
+FrameClock::FrameClock (int32_t fps) :
+    m_period(NSEC_PER_SEC / fps), m_next(0)
+{
+}
+
+
+int64_t FrameClock::now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+
+void FrameClock::start (void)
+{
+    m_next = now () + m_period;
+}
+
+
+int32_t FrameClock::wait (void)
+{
+    struct timespec ts;
+    int64_t late;
+    int32_t elapsed;
+
+    // sleep until the deadline, returns at once if it already passed
+    ts.tv_sec = m_next / NSEC_PER_SEC;
+    ts.tv_nsec = m_next % NSEC_PER_SEC;
+    while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+
+    // count every deadline up to now and schedule the next one after it
+    late = now () - m_next;
+    elapsed = 1 + (late > 0 ? late / m_period : 0);
+    m_next += elapsed * m_period;
+
+    return elapsed;
+}
@@ -8,39 +8,95 @@
 #ifndef __gammalut_h_
 #define __gammalut_h_
 
-static const uint8_t gammaLut[] = {
-  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-  0x00,0x00,0x01,0x01,0x01,0x01,0x01,0x01,
-  0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,
-  0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,
-  0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,
-  0x01,0x01,0x01,0x01,0x01,0x01,0x02,0x02,
-  0x02,0x02,0x02,0x02,0x02,0x02,0x02,0x02,
-  0x02,0x02,0x02,0x02,0x02,0x02,0x02,0x02,
-  0x02,0x02,0x02,0x02,0x02,0x03,0x03,0x03,
-  0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,
-  0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x04,
-  0x04,0x04,0x04,0x04,0x04,0x04,0x04,0x04,
-  0x04,0x04,0x04,0x04,0x04,0x04,0x05,0x05,
-  0x05,0x05,0x05,0x05,0x05,0x05,0x05,0x05,
-  0x05,0x05,0x05,0x06,0x06,0x06,0x06,0x06,
-  0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x07,
-  0x07,0x07,0x07,0x07,0x07,0x07,0x07,0x07,
-  0x07,0x07,0x08,0x08,0x08,0x08,0x08,0x08,
-  0x08,0x08,0x08,0x08,0x09,0x09,0x09,0x09,
-  0x09,0x09,0x09,0x09,0x09,0x0a,0x0a,0x0a,
-  0x0a,0x0a,0x0a,0x0a,0x0a,0x0a,0x0b,0x0b,
-  0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0c,0x0c,
-  0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x0d,0x0d,
-  0x0d,0x0d,0x0d,0x0d,0x0d,0x0e,0x0e,0x0e,
-  0x0e,0x0e,0x0e,0x0e,0x0f,0x0f,0x0f,0x0f
+// Gamma and quantization tables, generated by the compiler.
+//
+// MakeGammaTable fills a table with round (max out * (x / max in)^gamma) for every input x,
+// in whatever input and output depths the display needs: 8-bit color to the panels' 4-bit
+// PWM, to 8-bit WS2812B levels or to the 16-bit linear light the dither works from. The
+// math runs in constexpr functions, so the tables are constant data with no startup cost,
+// and each one is an inline variable with a single definition shared by every file that
+// includes this header.
+
+#if __cplusplus < 201703L
+#error gammalut.h needs C++17 for its inline tables
+#endif
+
+// the curve the panel tables were tuned by eye with
+#define GAMMA 2.5
+
+// one entry per input value from 0 to 2^IN_BITS - 1
+template <typename T, int IN_BITS>
+struct LevelTable
+{
+    T level[1 << IN_BITS];
+
+    constexpr const T &operator[] (int32_t x) const {
+        return level[x];
+    }
 };
 
+// e^y for y <= 0, as 2^n times a Taylor series for the remainder under ln 2 / 2
+constexpr double GammaExp (double y)
+{
+    const double ln2 = 0.69314718055994530942;
+    int32_t n = (y / ln2) - 0.5;
+    double r = y - n * ln2, term = 1.0, sum = 1.0;
+
+    for (int32_t k = 1; k < 24; k++) {
+        term *= r / k;
+        sum += term;
+    }
+    for (; n < 0; n++) {
+        sum *= 0.5;
+    }
+
+    return sum;
+}
+
+// ln x for 0 < x <= 1, as -n ln 2 plus 2 atanh ((m - 1) / (m + 1)) with m from 0.5 to 1
+constexpr double GammaLog (double x)
+{
+    const double ln2 = 0.69314718055994530942;
+    int32_t n = 0;
+    double sum = 0;
+
+    while (x < 0.5) {
+        x *= 2.0;
+        n++;
+    }
+
+    const double z = (x - 1.0) / (x + 1.0);
+    double term = z;
+    for (int32_t k = 1; k < 64; k += 2) {
+        sum += term / k;
+        term *= z * z;
+    }
+
+    return 2.0 * sum - n * ln2;
+}
+
+// x^gamma for x from 0 to 1
+constexpr double GammaPow (double x, double gamma)
+{
+    return (x <= 0) ? 0 : (x >= 1) ? 1 : GammaExp (gamma * GammaLog (x));
+}
+
+template <typename T, int IN_BITS, int OUT_BITS>
+constexpr LevelTable<T, IN_BITS> MakeGammaTable (double gamma)
+{
+    const double maxIn = (1 << IN_BITS) - 1;
+    const double maxOut = (1LL << OUT_BITS) - 1;
+    LevelTable<T, IN_BITS> table = { };
+
+    for (int32_t x = 0; x < (1 << IN_BITS); x++) {
+        table.level[x] = GammaPow (x / maxIn, gamma) * maxOut + 0.5;
+    }
+
+    return table;
+}
+
+// 8-bit color to the panels' 4-bit PWM levels, and to 16-bit linear light for the dither
+inline constexpr LevelTable<uint8_t, 8> gammaLut = MakeGammaTable<uint8_t, 8, 4> (GAMMA);
+inline constexpr LevelTable<uint16_t, 8> gammaLinear = MakeGammaTable<uint16_t, 8, 16> (GAMMA);
+
 #endif
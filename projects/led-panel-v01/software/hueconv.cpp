@@ -0,0 +1,711 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined (__x86_64__) || defined (__i386__)
+#include <immintrin.h>
+#define HUECONV_X86
+#elif defined (__arm__) || defined (__aarch64__)
+// on a 32-bit build without -mfpu=neon only the NEON kernels are built for it, HasNeon
+// decides at run time whether they are used, and the scalar kernels stay plain VFP
+#if defined (__arm__) && !defined (__ARM_NEON)
+#pragma GCC push_options
+#pragma GCC target ("fpu=neon")
+#include <arm_neon.h>
+#pragma GCC pop_options
+#define HUECONV_NEON_TARGET __attribute__ ((target ("fpu=neon")))
+#else
+#include <arm_neon.h>
+#define HUECONV_NEON_TARGET
+#endif
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define HUECONV_NEON
+#endif
+
+#include "pattern.h"
+#include "hueconv.h"
+
+// a 16-bit hue table split into low and high bytes for the shuffle kernels, and the same
+// with each 16 byte block XORed with the block before it
+typedef struct {
+    uint8_t lo[HUE_STEPS] __attribute__ ((aligned (16)));
+    uint8_t hi[HUE_STEPS] __attribute__ ((aligned (16)));
+    uint8_t loChain[HUE_STEPS] __attribute__ ((aligned (16)));
+    uint8_t hiChain[HUE_STEPS] __attribute__ ((aligned (16)));
+} HueBytes;
+
+// Each plane of gHueLinear goes round the wheel in 16 step segments that either hold still
+// or ramp up or down, all along the same 16 entry ramp. The step with index lo in segment
+// seg is ramp[((lo ^ flip[seg]) & mask[seg]) | fill[seg]], and the step after it is dir[seg]
+// further along the ramp, clamped to its ends. Those are all 16 byte tables, one shuffle
+// each, where the whole plane would take six.
+typedef struct {
+    uint8_t flip[16] __attribute__ ((aligned (16)));
+    uint8_t mask[16] __attribute__ ((aligned (16)));
+    uint8_t fill[16] __attribute__ ((aligned (16)));
+    int8_t dir[16] __attribute__ ((aligned (16)));
+    uint8_t lo[16] __attribute__ ((aligned (16)));
+    uint8_t hi[16] __attribute__ ((aligned (16)));
+} HueRamp;
+
+// levels = gHueLut at the nearest step to each Q16 hue
+typedef void (*HueRowKernel) (uint16_t *levels, const uint32_t *hues, int32_t count,
+    const HueBytes *lut);
+
+// red, green and blue = gHueLinear blended between the steps either side of each Q16 hue
+typedef void (*HueLinearKernel) (uint16_t *red, uint16_t *green, uint16_t *blue,
+    const uint32_t *hues, int32_t count);
+
+typedef struct {
+    const char *name;
+    HueRowKernel hueRow;
+    HueLinearKernel hueLinear;
+    bool (*supported) (void);
+} HueConvKernel;
+
+static HueBytes gHueBytes;
+static HueRamp gHueRamps[3];
+
+static const HueConvKernel *gKernel = NULL;
+
+// the first call picks the kernel, even when tile threads make several first calls at once
+static pthread_once_t gSelected = PTHREAD_ONCE_INIT;
+
+static void HueRowScalar (uint16_t *levels, const uint32_t *hues, int32_t count,
+    const HueBytes *lut);
+static void HueLinearScalar (uint16_t *red, uint16_t *green, uint16_t *blue,
+    const uint32_t *hues, int32_t count);
+static bool Always (void);
+static void SplitHue (HueBytes *lut, int32_t hue, uint16_t value);
+static void ChainHues (HueBytes *lut);
+static void BuildRamp (HueRamp *ramp, const uint16_t *plane);
+static void SelectKernel (void);
+
+
+//---------------------------------------------------------------------------------------------
+// scalar reference
+//
+
+static void HueRowScalar (uint16_t *levels, const uint32_t *hues, int32_t count,
+    const HueBytes *lut)
+{
+    for (int32_t i = 0; i < count; i++) {
+        uint32_t step = HueStep (hues[i]);
+        levels[i] = (lut->hi[step] << 8) | lut->lo[step];
+    }
+}
+
+
+static void HueLinearScalar (uint16_t *red, uint16_t *green, uint16_t *blue,
+    const uint32_t *hues, int32_t count)
+{
+    for (int32_t i = 0; i < count; i++) {
+        red[i] = HueLinear (0, hues[i]);
+        green[i] = HueLinear (1, hues[i]);
+        blue[i] = HueLinear (2, hues[i]);
+    }
+}
+
+
+static bool Always (void)
+{
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// x86, each 16 hue block of the byte tables is looked up with pshufb, which returns zero for
+// indexes with the high bit set. The chained tables hold each block XORed with the one
+// before it. Block k is looked up with the step minus 16 * k, which has the high bit set
+// for steps below the block, so XORing the lookups of every block leaves the block the step
+// is in. The nearest step is (hue >> 15) + 1 halved, one pavgb once packed to bytes. The
+// linear kernels blend with pmulhrsw, (a * b + 0x4000) >> 15, the same rounding as
+// HueLinear with the fraction in Q15.
+//
+
+#ifdef HUECONV_X86
+
+// 16 values under 256 in 32-bit lanes packed to bytes
+__attribute__ ((target ("sse4.1")))
+static inline __m128i PackBytesSse4 (const __m128i *h)
+{
+    return _mm_packus_epi16 (_mm_packus_epi32 (h[0], h[1]), _mm_packus_epi32 (h[2], h[3]));
+}
+
+
+__attribute__ ((target ("sse4.1")))
+static void HueRowSse4 (uint16_t *levels, const uint32_t *hues, int32_t count,
+    const HueBytes *lut)
+{
+    const __m128i block = _mm_set1_epi8 (16);
+    const __m128i wheel = _mm_set1_epi8 (HUE_STEPS);
+    __m128i table[2][HUE_STEPS / 16];
+    int32_t i, j, k;
+
+    for (k = 0; k < HUE_STEPS / 16; k++) {
+        table[0][k] = _mm_load_si128 ((const __m128i *)&lut->loChain[16 * k]);
+        table[1][k] = _mm_load_si128 ((const __m128i *)&lut->hiChain[16 * k]);
+    }
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m128i h[4];
+
+        for (j = 0; j < 4; j++) {
+            h[j] = _mm_srli_epi32 (_mm_loadu_si128 ((const __m128i *)&hues[i + 4 * j]), 15);
+        }
+
+        // nearest steps, 96 wrapped back to 0
+        __m128i steps = _mm_avg_epu8 (PackBytesSse4 (h), _mm_setzero_si128 ());
+        steps = _mm_min_epu8 (steps, _mm_sub_epi8 (steps, wheel));
+
+        __m128i lo = _mm_shuffle_epi8 (table[0][0], steps);
+        __m128i hi = _mm_shuffle_epi8 (table[1][0], steps);
+        for (k = 1; k < HUE_STEPS / 16; k++) {
+            steps = _mm_sub_epi8 (steps, block);
+            lo = _mm_xor_si128 (lo, _mm_shuffle_epi8 (table[0][k], steps));
+            hi = _mm_xor_si128 (hi, _mm_shuffle_epi8 (table[1][k], steps));
+        }
+
+        _mm_storeu_si128 ((__m128i *)&levels[i], _mm_unpacklo_epi8 (lo, hi));
+        _mm_storeu_si128 ((__m128i *)&levels[i + 8], _mm_unpackhi_epi8 (lo, hi));
+    }
+
+    HueRowScalar (&levels[i], &hues[i], count - i, lut);
+}
+
+
+__attribute__ ((target ("sse4.1")))
+static void HueLinearSse4 (uint16_t *red, uint16_t *green, uint16_t *blue,
+    const uint32_t *hues, int32_t count)
+{
+    uint16_t *planes[3] = { red, green, blue };
+    const __m128i nibble = _mm_set1_epi8 (0x0f);
+    const __m128i fraction = _mm_set1_epi32 (0xffff);
+    int32_t i, j, p;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m128i h[4], f[4], frac[2];
+
+        for (j = 0; j < 4; j++) {
+            h[j] = _mm_loadu_si128 ((const __m128i *)&hues[i + 4 * j]);
+            f[j] = _mm_srli_epi32 (_mm_and_si128 (h[j], fraction), 1);
+            h[j] = _mm_srli_epi32 (h[j], 16);
+        }
+        frac[0] = _mm_packus_epi32 (f[0], f[1]);
+        frac[1] = _mm_packus_epi32 (f[2], f[3]);
+
+        __m128i steps = PackBytesSse4 (h);
+        __m128i seg = _mm_and_si128 (_mm_srli_epi16 (steps, 4), nibble);
+        __m128i lo = _mm_and_si128 (steps, nibble);
+
+        for (p = 0; p < 3; p++) {
+            const HueRamp *ramp = &gHueRamps[p];
+            __m128i rlo = _mm_load_si128 ((const __m128i *)ramp->lo);
+            __m128i rhi = _mm_load_si128 ((const __m128i *)ramp->hi);
+
+            __m128i index = _mm_xor_si128 (lo,
+                _mm_shuffle_epi8 (_mm_load_si128 ((const __m128i *)ramp->flip), seg));
+            index = _mm_and_si128 (index,
+                _mm_shuffle_epi8 (_mm_load_si128 ((const __m128i *)ramp->mask), seg));
+            index = _mm_or_si128 (index,
+                _mm_shuffle_epi8 (_mm_load_si128 ((const __m128i *)ramp->fill), seg));
+
+            __m128i next = _mm_add_epi8 (index,
+                _mm_shuffle_epi8 (_mm_load_si128 ((const __m128i *)ramp->dir), seg));
+            next = _mm_max_epi8 (_mm_min_epi8 (next, nibble), _mm_setzero_si128 ());
+
+            __m128i blo = _mm_shuffle_epi8 (rlo, index);
+            __m128i bhi = _mm_shuffle_epi8 (rhi, index);
+            __m128i nlo = _mm_shuffle_epi8 (rlo, next);
+            __m128i nhi = _mm_shuffle_epi8 (rhi, next);
+
+            __m128i base[2] = { _mm_unpacklo_epi8 (blo, bhi), _mm_unpackhi_epi8 (blo, bhi) };
+            __m128i ends[2] = { _mm_unpacklo_epi8 (nlo, nhi), _mm_unpackhi_epi8 (nlo, nhi) };
+
+            for (j = 0; j < 2; j++) {
+                __m128i delta = _mm_mulhrs_epi16 (_mm_sub_epi16 (ends[j], base[j]), frac[j]);
+                _mm_storeu_si128 ((__m128i *)&planes[p][i + 8 * j],
+                    _mm_add_epi16 (base[j], delta));
+            }
+        }
+    }
+
+    HueLinearScalar (&red[i], &green[i], &blue[i], &hues[i], count - i);
+}
+
+
+// 32 values under 256 in 32-bit lanes packed to bytes. The packs work within 128-bit lanes,
+// so they leave groups of 4 pixels in the order 0 2 4 6 1 3 5 7. The permute puts pixels
+// 0-7 and 16-23 in the low lane, so the in lane unpacks to 16 bits come out as pixels 0-15
+// and 16-31 and can be stored as they are.
+__attribute__ ((target ("avx2")))
+static inline __m256i PackBytesAvx2 (const __m256i *h)
+{
+    return _mm256_permutevar8x32_epi32 (_mm256_packus_epi16 (
+        _mm256_packus_epi32 (h[0], h[1]), _mm256_packus_epi32 (h[2], h[3])),
+        _mm256_setr_epi32 (0, 4, 2, 6, 1, 5, 3, 7));
+}
+
+
+// a 16 byte table in both 128-bit lanes, vpshufb looks up within each lane
+__attribute__ ((target ("avx2")))
+static inline __m256i BroadcastAvx2 (const uint8_t *table)
+{
+    return _mm256_broadcastsi128_si256 (_mm_load_si128 ((const __m128i *)table));
+}
+
+
+__attribute__ ((target ("avx2")))
+static void HueRowAvx2 (uint16_t *levels, const uint32_t *hues, int32_t count,
+    const HueBytes *lut)
+{
+    const __m256i block = _mm256_set1_epi8 (16);
+    const __m256i wheel = _mm256_set1_epi8 (HUE_STEPS);
+    __m256i table[2][HUE_STEPS / 16];
+    int32_t i, j, k;
+
+    for (k = 0; k < HUE_STEPS / 16; k++) {
+        table[0][k] = BroadcastAvx2 (&lut->loChain[16 * k]);
+        table[1][k] = BroadcastAvx2 (&lut->hiChain[16 * k]);
+    }
+
+    for (i = 0; i + 32 <= count; i += 32) {
+        __m256i h[4];
+
+        for (j = 0; j < 4; j++) {
+            h[j] = _mm256_srli_epi32 (
+                _mm256_loadu_si256 ((const __m256i *)&hues[i + 8 * j]), 15);
+        }
+
+        __m256i steps = _mm256_avg_epu8 (PackBytesAvx2 (h), _mm256_setzero_si256 ());
+        steps = _mm256_min_epu8 (steps, _mm256_sub_epi8 (steps, wheel));
+
+        __m256i lo = _mm256_shuffle_epi8 (table[0][0], steps);
+        __m256i hi = _mm256_shuffle_epi8 (table[1][0], steps);
+        for (k = 1; k < HUE_STEPS / 16; k++) {
+            steps = _mm256_sub_epi8 (steps, block);
+            lo = _mm256_xor_si256 (lo, _mm256_shuffle_epi8 (table[0][k], steps));
+            hi = _mm256_xor_si256 (hi, _mm256_shuffle_epi8 (table[1][k], steps));
+        }
+
+        _mm256_storeu_si256 ((__m256i *)&levels[i], _mm256_unpacklo_epi8 (lo, hi));
+        _mm256_storeu_si256 ((__m256i *)&levels[i + 16], _mm256_unpackhi_epi8 (lo, hi));
+    }
+
+    HueRowScalar (&levels[i], &hues[i], count - i, lut);
+}
+
+
+__attribute__ ((target ("avx2")))
+static void HueLinearAvx2 (uint16_t *red, uint16_t *green, uint16_t *blue,
+    const uint32_t *hues, int32_t count)
+{
+    uint16_t *planes[3] = { red, green, blue };
+    const __m256i nibble = _mm256_set1_epi8 (0x0f);
+    const __m256i fraction = _mm256_set1_epi32 (0xffff);
+    int32_t i, j, p;
+
+    for (i = 0; i + 32 <= count; i += 32) {
+        __m256i h[4], f[4], frac[2];
+
+        for (j = 0; j < 4; j++) {
+            h[j] = _mm256_loadu_si256 ((const __m256i *)&hues[i + 8 * j]);
+            f[j] = _mm256_srli_epi32 (_mm256_and_si256 (h[j], fraction), 1);
+            h[j] = _mm256_srli_epi32 (h[j], 16);
+        }
+        // fractions in the same order as the unpacked steps
+        frac[0] = _mm256_permute4x64_epi64 (_mm256_packus_epi32 (f[0], f[1]), 0xd8);
+        frac[1] = _mm256_permute4x64_epi64 (_mm256_packus_epi32 (f[2], f[3]), 0xd8);
+
+        __m256i steps = PackBytesAvx2 (h);
+        __m256i seg = _mm256_and_si256 (_mm256_srli_epi16 (steps, 4), nibble);
+        __m256i lo = _mm256_and_si256 (steps, nibble);
+
+        for (p = 0; p < 3; p++) {
+            const HueRamp *ramp = &gHueRamps[p];
+            __m256i rlo = BroadcastAvx2 (ramp->lo);
+            __m256i rhi = BroadcastAvx2 (ramp->hi);
+
+            __m256i index = _mm256_xor_si256 (lo,
+                _mm256_shuffle_epi8 (BroadcastAvx2 (ramp->flip), seg));
+            index = _mm256_and_si256 (index,
+                _mm256_shuffle_epi8 (BroadcastAvx2 (ramp->mask), seg));
+            index = _mm256_or_si256 (index,
+                _mm256_shuffle_epi8 (BroadcastAvx2 (ramp->fill), seg));
+
+            __m256i next = _mm256_add_epi8 (index,
+                _mm256_shuffle_epi8 (BroadcastAvx2 ((const uint8_t *)ramp->dir), seg));
+            next = _mm256_max_epi8 (_mm256_min_epi8 (next, nibble), _mm256_setzero_si256 ());
+
+            __m256i blo = _mm256_shuffle_epi8 (rlo, index);
+            __m256i bhi = _mm256_shuffle_epi8 (rhi, index);
+            __m256i nlo = _mm256_shuffle_epi8 (rlo, next);
+            __m256i nhi = _mm256_shuffle_epi8 (rhi, next);
+
+            __m256i base[2] = {
+                _mm256_unpacklo_epi8 (blo, bhi), _mm256_unpackhi_epi8 (blo, bhi)
+            };
+            __m256i ends[2] = {
+                _mm256_unpacklo_epi8 (nlo, nhi), _mm256_unpackhi_epi8 (nlo, nhi)
+            };
+
+            for (j = 0; j < 2; j++) {
+                __m256i delta = _mm256_mulhrs_epi16 (_mm256_sub_epi16 (ends[j], base[j]),
+                    frac[j]);
+                _mm256_storeu_si256 ((__m256i *)&planes[p][i + 16 * j],
+                    _mm256_add_epi16 (base[j], delta));
+            }
+        }
+    }
+
+    HueLinearSse4 (&red[i], &green[i], &blue[i], &hues[i], count - i);
+}
+
+
+static bool HasSse4 (void)
+{
+    return __builtin_cpu_supports ("sse4.1");
+}
+
+
+static bool HasAvx2 (void)
+{
+    return __builtin_cpu_supports ("avx2");
+}
+
+#endif
+
+
+//---------------------------------------------------------------------------------------------
+// NEON, vtbl4 looks up 32 byte tables, vtbx4 fills in the hues the previous table missed.
+// The linear kernel blends with vqrdmulh, (2 * a * b + 0x8000) >> 16, which rounds the
+// same as HueLinear with the fraction in Q15.
+//
+
+#ifdef HUECONV_NEON
+
+// the steps of 8 Q16 hues, 96 wrapped back to 0
+HUECONV_NEON_TARGET
+static inline uint8x8_t StepsNeon (uint32x4_t a, uint32x4_t b)
+{
+    uint8x8_t steps = vmovn_u16 (vcombine_u16 (vshrn_n_u32 (a, 16), vshrn_n_u32 (b, 16)));
+
+    return vmin_u8 (steps, vsub_u8 (steps, vdup_n_u8 (HUE_STEPS)));
+}
+
+
+HUECONV_NEON_TARGET
+static void HueRowNeon (uint16_t *levels, const uint32_t *hues, int32_t count,
+    const HueBytes *lut)
+{
+    uint8x8x4_t table[2][HUE_STEPS / 32];
+    const uint8x8_t step = vdup_n_u8 (32);
+    const uint32x4_t half = vdupq_n_u32 (HUE_ONE / 2);
+    int32_t i, k, j;
+
+    for (k = 0; k < HUE_STEPS / 32; k++) {
+        for (j = 0; j < 4; j++) {
+            table[0][k].val[j] = vld1_u8 (&lut->lo[32 * k + 8 * j]);
+            table[1][k].val[j] = vld1_u8 (&lut->hi[32 * k + 8 * j]);
+        }
+    }
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        uint8x8_t index = StepsNeon (vaddq_u32 (vld1q_u32 (&hues[i]), half),
+            vaddq_u32 (vld1q_u32 (&hues[i + 4]), half));
+        uint8x8x2_t bytes;
+
+        bytes.val[0] = vtbl4_u8 (table[0][0], index);
+        bytes.val[1] = vtbl4_u8 (table[1][0], index);
+        for (k = 1; k < HUE_STEPS / 32; k++) {
+            index = vsub_u8 (index, step);
+            bytes.val[0] = vtbx4_u8 (bytes.val[0], table[0][k], index);
+            bytes.val[1] = vtbx4_u8 (bytes.val[1], table[1][k], index);
+        }
+
+        // interleaving the low and high bytes makes little endian 16-bit colors
+        vst2_u8 ((uint8_t *)&levels[i], bytes);
+    }
+
+    HueRowScalar (&levels[i], &hues[i], count - i, lut);
+}
+
+
+HUECONV_NEON_TARGET
+static void HueLinearNeon (uint16_t *red, uint16_t *green, uint16_t *blue,
+    const uint32_t *hues, int32_t count)
+{
+    uint16_t *planes[3] = { red, green, blue };
+    const uint32x4_t fraction = vdupq_n_u32 (0xffff);
+    const uint8x8_t nibble = vdup_n_u8 (0x0f);
+    uint8x8x2_t rlo, rhi;
+    int32_t i, p;
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        uint32x4_t a = vld1q_u32 (&hues[i]);
+        uint32x4_t b = vld1q_u32 (&hues[i + 4]);
+        int16x8_t frac = vreinterpretq_s16_u16 (vcombine_u16 (
+            vshrn_n_u32 (vandq_u32 (a, fraction), 1),
+            vshrn_n_u32 (vandq_u32 (b, fraction), 1)));
+        uint8x8_t steps = StepsNeon (a, b);
+        uint8x8_t seg = vshr_n_u8 (steps, 4);
+        uint8x8_t lo = vand_u8 (steps, nibble);
+
+        for (p = 0; p < 3; p++) {
+            const HueRamp *ramp = &gHueRamps[p];
+
+            // six segments, so the segment tables fit in one register
+            uint8x8_t index = veor_u8 (lo, vtbl1_u8 (vld1_u8 (ramp->flip), seg));
+            index = vand_u8 (index, vtbl1_u8 (vld1_u8 (ramp->mask), seg));
+            index = vorr_u8 (index, vtbl1_u8 (vld1_u8 (ramp->fill), seg));
+
+            int8x8_t next = vadd_s8 (vreinterpret_s8_u8 (index), vtbl1_s8 (vld1_s8 (ramp->dir),
+                vreinterpret_s8_u8 (seg)));
+            next = vmax_s8 (vmin_s8 (next, vdup_n_s8 (15)), vdup_n_s8 (0));
+
+            rlo.val[0] = vld1_u8 (&ramp->lo[0]);
+            rlo.val[1] = vld1_u8 (&ramp->lo[8]);
+            rhi.val[0] = vld1_u8 (&ramp->hi[0]);
+            rhi.val[1] = vld1_u8 (&ramp->hi[8]);
+
+            uint16x8_t base = vorrq_u16 (vmovl_u8 (vtbl2_u8 (rlo, index)),
+                vshll_n_u8 (vtbl2_u8 (rhi, index), 8));
+            uint16x8_t end = vorrq_u16 (vmovl_u8 (vtbl2_u8 (rlo, vreinterpret_u8_s8 (next))),
+                vshll_n_u8 (vtbl2_u8 (rhi, vreinterpret_u8_s8 (next)), 8));
+            int16x8_t delta = vqrdmulhq_s16 (
+                vreinterpretq_s16_u16 (vsubq_u16 (end, base)), frac);
+
+            vst1q_u16 (&planes[p][i], vaddq_u16 (base, vreinterpretq_u16_s16 (delta)));
+        }
+    }
+
+    HueLinearScalar (&red[i], &green[i], &blue[i], &hues[i], count - i);
+}
+
+
+static bool HasNeon (void)
+{
+#ifdef __arm__
+    return (getauxval (AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+    return true;
+#endif
+}
+
+#endif
+
+
+//---------------------------------------------------------------------------------------------
+// kernels, fastest last, AVX2 shares the SSE4 linear kernel
+//
+
+static const HueConvKernel gKernels[] = {
+    { "scalar", HueRowScalar, HueLinearScalar, Always  },
+#ifdef HUECONV_X86
+    { "sse4",   HueRowSse4,   HueLinearSse4,   HasSse4 },
+    { "avx2",   HueRowAvx2,   HueLinearAvx2,   HasAvx2 },
+#endif
+#ifdef HUECONV_NEON
+    { "neon",   HueRowNeon,   HueLinearNeon,   HasNeon },
+#endif
+};
+
+#define NUM_KERNELS (int32_t)(sizeof (gKernels) / sizeof (gKernels[0]))
+
+
+static void SplitHue (HueBytes *lut, int32_t hue, uint16_t value)
+{
+    lut->lo[hue] = value & 0xff;
+    lut->hi[hue] = value >> 8;
+}
+
+
+static void ChainHues (HueBytes *lut)
+{
+    for (int32_t i = 0; i < HUE_STEPS; i++) {
+        lut->loChain[i] = (i < 16) ? lut->lo[i] : lut->lo[i] ^ lut->lo[i - 16];
+        lut->hiChain[i] = (i < 16) ? lut->hi[i] : lut->hi[i] ^ lut->hi[i - 16];
+    }
+}
+
+
+// the ramp is the first segment that rises, the others are matched against it
+static void BuildRamp (HueRamp *ramp, const uint16_t *plane)
+{
+    const uint16_t *up = plane;
+    int32_t seg, i;
+
+    for (seg = 0; seg < HUE_STEPS / 16; seg++) {
+        if (plane[16 * seg] < plane[16 * seg + 15]) {
+            up = &plane[16 * seg];
+            break;
+        }
+    }
+
+    for (i = 0; i < 16; i++) {
+        ramp->lo[i] = up[i] & 0xff;
+        ramp->hi[i] = up[i] >> 8;
+    }
+
+    memset (ramp->flip, 0, sizeof (ramp->flip));
+    memset (ramp->mask, 0, sizeof (ramp->mask));
+    memset (ramp->fill, 0, sizeof (ramp->fill));
+    memset (ramp->dir, 0, sizeof (ramp->dir));
+
+    for (seg = 0; seg < HUE_STEPS / 16; seg++) {
+        uint16_t first = plane[16 * seg];
+        uint16_t last = plane[16 * seg + 15];
+
+        if (first < last) {
+            ramp->mask[seg] = 0x0f;
+            ramp->dir[seg] = 1;
+        } else if (first > last) {
+            ramp->flip[seg] = 0x0f;
+            ramp->mask[seg] = 0x0f;
+            ramp->dir[seg] = -1;
+        } else {
+            ramp->fill[seg] = (first == up[15]) ? 0x0f : 0;
+        }
+    }
+}
+
+
+// kernel by name if this cpu supports it, else NULL
+static const HueConvKernel *FindKernel (const char *name)
+{
+    for (int32_t i = 0; i < NUM_KERNELS; i++) {
+        if (!strcmp (gKernels[i].name, name) && gKernels[i].supported ()) {
+            return &gKernels[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+static void SelectKernel (void)
+{
+    const char *name = getenv ("HUECONV_KERNEL");
+    int32_t i;
+
+    for (i = 0; i < HUE_STEPS; i++) {
+        SplitHue (&gHueBytes, i, gHueLut[i]);
+    }
+    ChainHues (&gHueBytes);
+    for (i = 0; i < 3; i++) {
+        BuildRamp (&gHueRamps[i], gHueLinear[i]);
+    }
+
+    for (i = NUM_KERNELS - 1; i >= 0; i--) {
+        if (gKernels[i].supported ()) {
+            gKernel = &gKernels[i];
+            break;
+        }
+    }
+
+    // look the override up directly, HueConvSetKernel would wait on this once routine
+    if (name != NULL) {
+        const HueConvKernel *kernel = FindKernel (name);
+        if (kernel != NULL) {
+            gKernel = kernel;
+        } else {
+            fprintf (stderr, "HUECONV_KERNEL=%s not available, using the fastest kernel\n",
+                name);
+        }
+    }
+}
+
+
+const char *HueConvGetKernel (void)
+{
+    pthread_once (&gSelected, SelectKernel);
+
+    return gKernel->name;
+}
+
+
+bool HueConvSetKernel (const char *name)
+{
+    const HueConvKernel *kernel;
+
+    pthread_once (&gSelected, SelectKernel);
+
+    kernel = FindKernel (name);
+    if (kernel == NULL) {
+        return false;
+    }
+
+    gKernel = kernel;
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// row conversion
+//
+
+void ConvertHueRow (uint16_t *levels, const uint32_t *hues, int32_t count)
+{
+    pthread_once (&gSelected, SelectKernel);
+
+    gKernel->hueRow (levels, hues, count, &gHueBytes);
+}
+
+
+void ConvertHueRowLinear (uint16_t *red, uint16_t *green, uint16_t *blue,
+    const uint32_t *hues, int32_t count)
+{
+    pthread_once (&gSelected, SelectKernel);
+
+    gKernel->hueLinear (red, green, blue, hues, count);
+}
+
+
+void ConvertHueValueRow (uint16_t *levels, const uint32_t *hues, const uint16_t *values,
+    int32_t count)
+{
+    for (int32_t i = 0; i < count; i++) {
+        levels[i] = gHueValueLut[values[i]][HueStep (hues[i])];
+    }
+}
+
+
+void ConvertHueValueRowLinear (uint16_t *red, uint16_t *green, uint16_t *blue,
+    const uint32_t *hues, const uint16_t *values, int32_t count)
+{
+    pthread_once (&gSelected, SelectKernel);
+
+    gKernel->hueLinear (red, green, blue, hues, count);
+
+    for (int32_t i = 0; i < count; i++) {
+        uint32_t value = gValueLinear[values[i]];
+        red[i] = (red[i] * value + 0x8000) >> 16;
+        green[i] = (green[i] * value + 0x8000) >> 16;
+        blue[i] = (blue[i] * value + 0x8000) >> 16;
+    }
+}
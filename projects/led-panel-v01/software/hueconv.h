@@ -0,0 +1,59 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#ifndef __hueconv_h_
+#define __hueconv_h_
+
+// Row at a time hue to color conversion.
+//
+// Patterns work out a row of Q16 hues, and optionally Q8 brightnesses, then convert the whole
+// row with one call. For 12-bit colors each hue is rounded to its nearest step, and the hue
+// kernels split gHueLut into low and high byte tables and look up 8 to 32 pixels at once with
+// byte shuffles: NEON vtbl on the BeagleBone, SSE4 pshufb or AVX2 vpshufb on x86. The fastest
+// kernel the cpu supports is picked on the first call, or the one named by the HUECONV_KERNEL
+// environment variable, so a check run can compare every kernel against the scalar
+// reference. The hue and brightness table is too big for byte shuffles, so every kernel
+// converts those rows with the scalar loop. The linear versions fill one row of each gLinear
+// plane with gHueLinear blended between the steps either side of each hue, which keeps the
+// fraction a slow rotation moves by for the quantizer to turn into dither. Every 16 steps of
+// a plane are flat or one ramp, so those kernels shuffle 16 entry tables instead.
+
+// convert count Q16 hues from 0 to HUE_WHEEL - 1 to 12-bit colors
+void ConvertHueRow (uint16_t *levels, const uint32_t *hues, int32_t count);
+
+// same with brightnesses from 0 to VALUE_ONE
+void ConvertHueValueRow (uint16_t *levels, const uint32_t *hues, const uint16_t *values,
+    int32_t count);
+
+// same, to 16-bit linear red, green and blue
+void ConvertHueRowLinear (uint16_t *red, uint16_t *green, uint16_t *blue,
+    const uint32_t *hues, int32_t count);
+void ConvertHueValueRowLinear (uint16_t *red, uint16_t *green, uint16_t *blue,
+    const uint32_t *hues, const uint16_t *values, int32_t count);
+
+// name of the kernel in use: scalar, neon, sse4 or avx2
+const char *HueConvGetKernel (void);
+
+// use the named kernel, returns false if this cpu or build doesn't have it
+bool HueConvSetKernel (const char *name);
+
+#endif
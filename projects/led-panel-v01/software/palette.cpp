@@ -0,0 +1,56 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "globals.h"
+#include "palette.h"
+
+// pixels per frame
+#define PIXELS (DISPLAY_HEIGHT * DISPLAY_WIDTH)
+
+#if (PALETTE_SIZE != 256)
+#error palette indices wrap as 8-bit values
+#endif
+
+
+//---------------------------------------------------------------------------------------------
+// map -- the rotation is folded into a copy of the palette first, so each pixel is one load
+//
+
+void PaletteMap (const uint8_t *indices, const uint16_t *palette, int32_t rotate,
+    uint16_t *levels)
+{
+    uint16_t rotated[PALETTE_SIZE];
+    int32_t i;
+
+    for (i = 0; i < PALETTE_SIZE; i++) {
+        rotated[i] = palette[(i + rotate) & (PALETTE_SIZE - 1)];
+    }
+
+    for (i = 0; i < PIXELS; i++) {
+        levels[i] = rotated[indices[i]];
+    }
+}
@@ -0,0 +1,37 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#ifndef __palette_h_
+#define __palette_h_
+
+// Palette indexed frames.
+//
+// A pattern whose colors only move around a fixed set, like a hue field sliding around the
+// color wheel, draws 8-bit indices once and then just changes the palette or its rotation
+// from frame to frame. The present thread turns indices into levels with one lookup per
+// pixel, so cycling the colors costs nothing at render time however large the display is.
+
+// levels of a whole frame of indices, each shown as palette[(index + rotate) % PALETTE_SIZE]
+void PaletteMap (const uint8_t *indices, const uint16_t *palette, int32_t rotate,
+    uint16_t *levels);
+
+#endif
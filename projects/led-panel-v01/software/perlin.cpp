@@ -43,41 +43,79 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <math.h>
+#include <float.h>
 #include <assert.h>
 
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#define PERLIN_SSE2
+#elif defined (__ARM_NEON)
+#include <arm_neon.h>
+#define PERLIN_NEON
+#endif
+
 #include "globals.h"
+#include "gammalut.h"
 #include "pattern.h"
+#include "tiles.h"
 #include "perlin.h"
 
+// the permutation table repeats the lattice every 256 cells along each axis
+#define PERLIN_PERIOD 256
+
+// each numeric type's name for PERLIN_NUMERIC, the minimum and maximum the normalization
+// starts from in its units of noise, and the most lattice cells its integer part of z reaches
+typedef struct {
+    const char *name;
+    float start;
+    int32_t periods;
+} PerlinNumbers;
+
+static const PerlinNumbers gNumbers[PERLIN_NUMERICS] = {
+    { "float",  0.0001, 1 << 24 },
+    { "q8.8",   1,      256     },
+    { "q16.16", 1,      65536   }
+};
+
+// the numbers the noise can be worked out in, see the policies at the end
+struct PerlinFloat;
+struct PerlinQ8_8;
+struct PerlinQ16_16;
+
+static PerlinNumeric FastestNumeric (void);
+
 
 //---------------------------------------------------------------------------------------------
 // constructors
 //
 
-Perlin::Perlin 
+Perlin::Perlin
 (
     const int32_t width, const int32_t height, const int32_t mode
-) : 
-    Pattern (width, height), 
-    m_mode (mode), m_xy_scale(8.0/64.0), 
-    m_z_step(0.0125), m_z_depth(512.0), 
-    m_hue_options(0.005)
+) :
+    Pattern (width, height),
+    m_mode (mode), m_xy_scale(8.0/64.0),
+    m_z_step(0.0125), m_z_depth(512.0),
+    m_hue_options(0.005), m_loop (false)
 {
+    specialize ();
 }
 
 
 Perlin::Perlin (
     const int32_t width, const int32_t height,
-    const int32_t mode, const float xy_scale, 
-    const float z_step, const float z_depth, 
+    const int32_t mode, const float xy_scale,
+    const float z_step, const float z_depth,
     const float hue_options
-) : 
-    Pattern (width, height), 
-    m_mode (mode), m_xy_scale(xy_scale), 
-    m_z_step(z_step), m_z_depth(z_depth), 
-    m_hue_options(hue_options)
+) :
+    Pattern (width, height),
+    m_mode (mode), m_xy_scale(xy_scale),
+    m_z_step(z_step), m_z_depth(z_depth),
+    m_hue_options(hue_options), m_loop (false)
 {
+    specialize ();
 }
 
 
@@ -102,9 +140,66 @@ void Perlin::init (void)
     // reset to red, only used for modes two and three
     m_hue_state = 0.0;
 
-    // reset normalization min and max 
-    m_min = 0.0001;
-    m_max = 0.0001;
+    // reset normalization min and max
+    m_min = gNumbers[m_numeric].start;
+    m_max = gNumbers[m_numeric].start;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// numbers and mode -- pick the noise and draw loops compiled for them
+//
+
+void Perlin::specialize (void)
+{
+    switch (m_mode) {
+        case 1: m_drawBand = &Perlin::drawBand<1>; break;
+        case 2: m_drawBand = &Perlin::drawBand<2>; break;
+        case 3: m_drawBand = &Perlin::drawBand<3>; break;
+        default: m_drawBand = &Perlin::drawBand<0>; break;
+    }
+
+    setNumeric (FastestNumeric ());
+}
+
+
+void Perlin::setNumeric (PerlinNumeric numeric)
+{
+    switch (numeric) {
+        case PERLIN_Q8_8: m_noiseBand = &Perlin::noiseBand<PerlinQ8_8>; break;
+        case PERLIN_Q16_16: m_noiseBand = &Perlin::noiseBand<PerlinQ16_16>; break;
+        default: numeric = PERLIN_FLOAT; m_noiseBand = &Perlin::noiseBand<PerlinFloat>; break;
+    }
+
+    // the noise comes out in different units, so the normalization starts over
+    m_numeric = numeric;
+    m_min = gNumbers[m_numeric].start;
+    m_max = gNumbers[m_numeric].start;
+}
+
+
+// Every build runs all three, so the fastest depends only on the cpu family: float's 4 SSE2
+// lanes beat q8.8's 8 lanes of 16-bit multiplies on x86, and q8.8 is why the BeagleBone's
+// fixed point version was written, its NEON has the 8 lanes and its VFP is slow.
+static PerlinNumeric FastestNumeric (void)
+{
+    const char *name = getenv ("PERLIN_NUMERIC");
+    int32_t i;
+
+    if (name != NULL) {
+        for (i = 0; i < PERLIN_NUMERICS; i++) {
+            if (!strcmp (gNumbers[i].name, name)) {
+                return (PerlinNumeric)i;
+            }
+        }
+        fprintf (stderr, "PERLIN_NUMERIC=%s not available, using the fastest\n", name);
+    }
+
+#if defined (__x86_64__) || defined (__i386__)
+    return PERLIN_FLOAT;
+#else
+    return PERLIN_Q8_8;
+#endif
 }
 
 
@@ -113,77 +208,123 @@ void Perlin::init (void)
 //
 
 bool Perlin::next (void)
+{
+    int32_t band, bands;
+    float lo, hi;
+
+    m_period = PERLIN_PERIOD;
+    m_depth = m_z_depth;
+
+    // looping noise repeats after the z depth in whole lattice cells, at most as many as the
+    // integer part of z reaches
+    if (m_loop) {
+        m_period = (m_z_depth < 1) ? 1 : (int32_t)(m_z_depth + 0.5);
+        if (m_period > gNumbers[m_numeric].periods) {
+            m_period = gNumbers[m_numeric].periods;
+        }
+        m_depth = m_period;
+    }
+
+    // noise for every band, then the normalization each band starts from, in band order so
+    // every pixel is normalized by the same running minimum and maximum as drawn row by row
+    renderBands (0);
+
+    bands = (m_height + TILE_ROWS - 1) / TILE_ROWS;
+    for (band = 0; band < bands; band++) {
+        lo = m_bandMin[band];
+        hi = m_bandMax[band];
+        m_bandMin[band] = m_min;
+        m_bandMax[band] = m_max;
+        if (hi > m_max) m_max = hi;
+        if (lo < m_min) m_min = lo;
+    }
+
+    // colors for every band
+    renderBands (1);
+
+    // update state variables
+    m_z_state = fmod (m_z_state + m_z_step, m_depth);
+    m_hue_state = fmod (m_hue_state + m_hue_options, 1.0);
+
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// draw one band of rows, noise on pass 0 and colors on pass 1
+//
+
+void Perlin::renderBand (int32_t pass, int32_t band, int32_t first, int32_t count)
+{
+    if (pass == 0) {
+        (this->*m_noiseBand) (band, first, count);
+    } else {
+        (this->*m_drawBand) (band, first, count);
+    }
+}
+
+
+template <int32_t MODE>
+void Perlin::drawBand (int32_t band, int32_t first, int32_t count)
 {
     int32_t x, y;
-    float sx, sy, n1, n2, n;
+    float n, min = m_bandMin[band], max = m_bandMax[band];
     int32_t hue;
+    uint32_t hues[DISPLAY_WIDTH];
+    uint16_t values[DISPLAY_WIDTH];
 
     // row
-    for (y = 0; y < m_height; y++) {
-
-        // scale y
-        sy = (float)y * m_xy_scale;
+    for (y = first; y < first + count; y++) {
 
         // column
-        for (x =0; x < m_width; x++) {
-
-            // scale x
-            sx = (float)x * m_xy_scale;
+        for (x = 0; x < m_width; x++) {
 
-            // generate noise at plane z_state
-            n1 = this->noise (sx, sy, m_z_state);
+            n = m_noise[y][x];
 
-            // generate noise at plane z_state - z_depth 
-            n2 = this->noise (sx, sy, m_z_state - m_z_depth);
+            // normalize combined noises to a number between 0 and 1
+            if (n > max) max = n;
+            if (n < min) min = n;
+            n = n + fabs (min);                 // make noise a positive value
+            n = n / (max + fabs (min));         // scale noise to between 0 and 1
 
-            // combine noises to make a seamless transition from plane 
-            // at z = z_depth back to plane at z = 0
-            n = ((m_z_depth - m_z_state) * n1 + (m_z_state) * n2) / m_z_depth;
+            // set hue and/or brightness based on mode, picked when the loop is compiled
+            if constexpr (MODE == 1) {
 
-            // normalize combined noises to a number between 0 and 1
-            if (n > m_max) m_max = n;
-            if (n < m_min) m_min = n;
-            n = n + fabs (m_min);               // make noise a positive value
-            n = n / (m_max + fabs (m_min));     // scale noise to between 0 and 1
-
-            // set hue and/or brightness based on mode
-            switch (m_mode) {
-        
                 // base hue fixed, varies based on noise
-                case 1:
-                    hue = (m_hue_options + n)*96.0 + 0.5;
-                    hue = hue % 96;
-                    gLevels[y][x] = this->translateHue (hue);
-                    break;
+                hue = (m_hue_options + n) * (double)HUE_WHEEL;
+                hue = hue % HUE_WHEEL;
+                hues[x] = hue;
+
+            } else if constexpr (MODE == 2) {
 
                 // hue rotates at constant velocity, varies based on noise
-                case 2:
-                    hue = (m_hue_state + n)*96.0 + 0.5;
-                    hue = hue % 96;
-                    gLevels[y][x] = this->translateHue (hue);
-                    break;
+                hue = (m_hue_state + n) * (double)HUE_WHEEL;
+                hue = hue % HUE_WHEEL;
+                hues[x] = hue;
+
+            } else if constexpr (MODE == 3) {
 
                 // hue rotates at constant velocity, brightness varies based on noise
-                case 3: 
-                    hue = (m_hue_state)*96.0 + 0.5;
-                    hue = hue % 96;
-                    gLevels[y][x] = this->translateHueValue (hue, n);
-                    break;
+                hue = (m_hue_state) * (double)HUE_WHEEL;
+                hue = hue % HUE_WHEEL;
+                hues[x] = hue;
+                values[x] = n * VALUE_ONE + 0.5f;
 
-                // undefined mode, blank display
-                default:
-                    gLevels[x][y] = 0;
-                    break;
+            } else {
 
+                // undefined mode, blank display
+                hues[x] = 0;
+                values[x] = 0;
             }
         }
-    }
-
-    // update state variables
-    m_z_state = fmod (m_z_state + m_z_step, m_z_depth);
-    m_hue_state = fmod (m_hue_state + m_hue_options, 1.0);
 
-    return true;
+        // convert the whole row at once
+        if constexpr ((MODE == 1) || (MODE == 2)) {
+            storeHueRow (y, hues);
+        } else {
+            storeHueValueRow (y, hues, values);
+        }
+    }
 }
 
 
@@ -215,14 +356,15 @@ bool Perlin::next (void)
 //
 
 #define lerp(t, a, b) ((a) + (t) * ((b) - (a)))
+#define lerp1(t, a, b) (((a)<<12) + (t) * ((b) - (a)))
 
-static const float GRAD3[][3] = {
-    {1,1,0},{-1,1,0},{1,-1,0},{-1,-1,0}, 
-    {1,0,1},{-1,0,1},{1,0,-1},{-1,0,-1}, 
+static const int8_t GRAD3[16][3] = {
+    {1,1,0},{-1,1,0},{1,-1,0},{-1,-1,0},
+    {1,0,1},{-1,0,1},{1,0,-1},{-1,0,-1},
     {0,1,1},{0,-1,1},{0,1,-1},{0,-1,-1},
     {1,0,-1},{-1,0,-1},{0,-1,1},{0,1,1}};
 
-static const unsigned char PERM[] = {
+static const uint8_t PERM[512] = {
   151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140,
   36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23, 190, 6, 148, 247, 120,
   234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32, 57, 177, 33,
@@ -256,56 +398,801 @@ static const unsigned char PERM[] = {
   205, 93, 222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156,
   180};
 
-float inline grad3(const int hash, const float x, const float y, const float z)
+// Perlin's quintic fade 6t^5 - 15t^4 + 10t^3 of each IN_BITS fraction, rounded down to
+// OUT_BITS so the largest fraction stays below one
+template <typename T, int IN_BITS, int OUT_BITS>
+constexpr LevelTable<T, IN_BITS> MakeEasingTable (void)
 {
-    const int h = hash & 15;
-    return x * GRAD3[h][0] + y * GRAD3[h][1] + z * GRAD3[h][2];
+    LevelTable<T, IN_BITS> table = { };
+
+    for (int32_t x = 0; x < (1 << IN_BITS); x++) {
+        double t = (double)x / (1 << IN_BITS);
+        table.level[x] = t * t * t * (t * (t * 6 - 15) + 10) * (1 << OUT_BITS);
+    }
+
+    return table;
 }
 
-float Perlin::noise (float x, float y, float z)
+// 8-bit fractions to the 12-bit weights the lerps take
+static constexpr LevelTable<uint16_t, 8> easing_function_lut =
+    MakeEasingTable<uint16_t, 8, 12> ();
+
+
+//---------------------------------------------------------------------------------------------
+// noiseBand -- noise for a band of rows in the numbers of policy N
+//
+// A policy has the Coord type the lattice coordinates are kept in and the Value type the
+// noise comes out in, Scale and Depth to turn pixel positions and z into coordinates, Noise
+// for a single sample and Row for count samples along x that share y and z, matching Noise
+// at every sample.
+//
+
+template <class N>
+void Perlin::noiseBand (int32_t band, int32_t first, int32_t count)
 {
-    float fx, fy, fz;
-    int A, AA, AB, B, BA, BB;
-
-    // find nearest whole number to each input coordinate
-    int i = (int)floorf(x);
-    int j = (int)floorf(y);
-    int k = (int)floorf(z);
-    int ii = i + 1;
-    int jj = j + 1;
-    int kk = k + 1;
-
-    // ensure all inputs to permutation functions are between 0 and 255
-    i &= 0xff;
-    ii &= 0xff;
-    j &= 0xff;
-    jj &= 0xff;
-    k &= 0xff;
-    kk &= 0xff;
-
-    // convert each input to a number between 0 and 1
-    x -= floorf(x); y -= floorf(y); z -= floorf(z);
-
-    // apply easing function
-    fx = x*x*x * (x * (x * 6 - 15) + 10);
-    fy = y*y*y * (y * (y * 6 - 15) + 10);
-    fz = z*z*z * (z * (z * 6 - 15) + 10);
-
-    // apply permutation function
-    A = PERM[i];
-    AA = PERM[A + j];
-    AB = PERM[A + jj];
-    B = PERM[ii];
-    BA = PERM[B + j];
-    BB = PERM[B + jj];
-
-    // six linear interpolations
-    return lerp(fz, lerp(fy, lerp(fx, grad3(PERM[AA + k], x, y, z),
-                                      grad3(PERM[BA + k], x - 1, y, z)),
-                             lerp(fx, grad3(PERM[AB + k], x, y - 1, z),
-                                      grad3(PERM[BB + k], x - 1, y - 1, z))),
-                    lerp(fy, lerp(fx, grad3(PERM[AA + kk], x, y, z - 1),
-                                      grad3(PERM[BA + kk], x - 1, y, z - 1)),
-                             lerp(fx, grad3(PERM[AB + kk], x, y - 1, z - 1),
-                                      grad3(PERM[BB + kk], x - 1, y - 1, z - 1))));
+    int32_t x, y;
+    typename N::Coord sx[DISPLAY_WIDTH], sy;
+    const typename N::Coord sz1 = N::Depth (m_z_state);
+    const typename N::Coord sz2 = N::Depth (m_z_state - m_z_depth);
+    typename N::Value n1[DISPLAY_WIDTH], n2[DISPLAY_WIDTH];
+    float *n, lo = FLT_MAX, hi = -FLT_MAX;
+
+    // scale x, the same for every row
+    for (x = 0; x < m_width; x++) {
+        sx[x] = N::Scale (x, m_xy_scale);
+    }
+
+    // row
+    for (y = first; y < first + count; y++) {
+
+        // scale y
+        sy = N::Scale (y, m_xy_scale);
+        n = m_noise[y];
+
+        // generate noise at plane z_state, and at plane z_state - z_depth unless looping
+        N::Row (sx, sy, sz1, m_period, m_width, n1);
+        if (!m_loop) {
+            N::Row (sx, sy, sz2, m_period, m_width, n2);
+        }
+
+        // column
+        for (x = 0; x < m_width; x++) {
+
+            // combine noises to make a seamless transition from plane
+            // at z = z_depth back to plane at z = 0, looping noise is seamless by itself
+            if (m_loop) {
+                n[x] = n1[x];
+            } else {
+                n[x] = ((m_z_depth - m_z_state) * (float)n1[x] +
+                    (m_z_state) * (float)n2[x]) / m_z_depth;
+            }
+
+            if (n[x] > hi) hi = n[x];
+            if (n[x] < lo) lo = n[x];
+        }
+    }
+
+    m_bandMin[band] = lo;
+    m_bandMax[band] = hi;
 }
+
+
+//---------------------------------------------------------------------------------------------
+// float -- Row works 4 samples at a time
+//
+// With y and z fixed for the row, a sample's eight corner hashes depend only on its lattice
+// cell in x, and at the usual scales several samples in a row share each cell. The corners
+// are hashed once per cell, as each new cell comes up, and kept as each gradient's x
+// component and the y and z half of its dot product, tabled by hash once per call. When all
+// four samples are in one cell the corners are broadcast, otherwise each lane picks them up
+// from the cache. Neither SSE2 nor NEON can look up the 512 entry permutation table, so the
+// hashing stays scalar, while the floors, fades, dot products and lerps run across 4 samples
+// at once, in the same order as Noise (). Each dot product has a single rounding whichever
+// way its two terms are added, so the results match Noise () exactly.
+//
+
+struct PerlinFloat
+{
+    typedef float Coord;
+    typedef float Value;
+
+    static const int32_t LANES = 4;
+
+    static Coord Scale (int32_t i, float scale)
+    {
+        return (float)i * scale;
+    }
+
+    static Coord Depth (float z)
+    {
+        return z;
+    }
+
+    static float Grad (const int hash, const float x, const float y, const float z)
+    {
+        const int h = hash & 15;
+        return x * GRAD3[h][0] + y * GRAD3[h][1] + z * GRAD3[h][2];
+    }
+
+    // lattice cell of z wrapped at the period, cells below zero count back from the end
+    static int ZCell (float z, int32_t period)
+    {
+        int k = (int)floorf(z) % period;
+        return (k < 0) ? k + period : k;
+    }
+
+    static float Fade (float t)
+    {
+        return t*t*t * (t * (t * 6 - 15) + 10);
+    }
+
+    static Value Noise (float x, float y, float z, int32_t period)
+    {
+        float fx, fy, fz;
+        int A, AA, AB, B, BA, BB;
+
+        // find nearest whole number to each input coordinate
+        int i = (int)floorf(x);
+        int j = (int)floorf(y);
+        int k = ZCell(z, period);
+        int ii = i + 1;
+        int jj = j + 1;
+        int kk = (k + 1 < period) ? k + 1 : 0;
+
+        // ensure all inputs to permutation functions are between 0 and 255
+        i &= 0xff;
+        ii &= 0xff;
+        j &= 0xff;
+        jj &= 0xff;
+        k &= 0xff;
+        kk &= 0xff;
+
+        // convert each input to a number between 0 and 1
+        x -= floorf(x); y -= floorf(y); z -= floorf(z);
+
+        // apply easing function
+        fx = x*x*x * (x * (x * 6 - 15) + 10);
+        fy = y*y*y * (y * (y * 6 - 15) + 10);
+        fz = z*z*z * (z * (z * 6 - 15) + 10);
+
+        // apply permutation function
+        A = PERM[i];
+        AA = PERM[A + j];
+        AB = PERM[A + jj];
+        B = PERM[ii];
+        BA = PERM[B + j];
+        BB = PERM[B + jj];
+
+        // six linear interpolations
+        return lerp(fz, lerp(fy, lerp(fx, Grad(PERM[AA + k], x, y, z),
+                                          Grad(PERM[BA + k], x - 1, y, z)),
+                                 lerp(fx, Grad(PERM[AB + k], x, y - 1, z),
+                                          Grad(PERM[BB + k], x - 1, y - 1, z))),
+                        lerp(fy, lerp(fx, Grad(PERM[AA + kk], x, y, z - 1),
+                                          Grad(PERM[BA + kk], x - 1, y, z - 1)),
+                                 lerp(fx, Grad(PERM[AB + kk], x, y - 1, z - 1),
+                                          Grad(PERM[BB + kk], x - 1, y - 1, z - 1))));
+    }
+
+#if defined (PERLIN_SSE2)
+
+    typedef __m128 Lanes;
+
+    static Lanes Load (const float *p)
+    {
+        return _mm_loadu_ps (p);
+    }
+
+    static void Store (float *p, Lanes a)
+    {
+        _mm_storeu_ps (p, a);
+    }
+
+    static Lanes Set (float a)
+    {
+        return _mm_set1_ps (a);
+    }
+
+    static Lanes Add (Lanes a, Lanes b)
+    {
+        return _mm_add_ps (a, b);
+    }
+
+    static Lanes Sub (Lanes a, Lanes b)
+    {
+        return _mm_sub_ps (a, b);
+    }
+
+    static Lanes Mul (Lanes a, Lanes b)
+    {
+        return _mm_mul_ps (a, b);
+    }
+
+    // x - floor (x), and floor (x) in cell, truncation rounds negative x up so those drop
+    static Lanes Fraction (Lanes x, int32_t *cell)
+    {
+        __m128i i = _mm_cvttps_epi32 (x);
+        i = _mm_add_epi32 (i, _mm_castps_si128 (_mm_cmpgt_ps (_mm_cvtepi32_ps (i), x)));
+        _mm_storeu_si128 ((__m128i *)cell, i);
+        return _mm_sub_ps (x, _mm_cvtepi32_ps (i));
+    }
+
+#elif defined (PERLIN_NEON)
+
+    typedef float32x4_t Lanes;
+
+    static Lanes Load (const float *p)
+    {
+        return vld1q_f32 (p);
+    }
+
+    static void Store (float *p, Lanes a)
+    {
+        vst1q_f32 (p, a);
+    }
+
+    static Lanes Set (float a)
+    {
+        return vdupq_n_f32 (a);
+    }
+
+    static Lanes Add (Lanes a, Lanes b)
+    {
+        return vaddq_f32 (a, b);
+    }
+
+    static Lanes Sub (Lanes a, Lanes b)
+    {
+        return vsubq_f32 (a, b);
+    }
+
+    static Lanes Mul (Lanes a, Lanes b)
+    {
+        return vmulq_f32 (a, b);
+    }
+
+    // x - floor (x), and floor (x) in cell, truncation rounds negative x up so those drop
+    static Lanes Fraction (Lanes x, int32_t *cell)
+    {
+        int32x4_t i = vcvtq_s32_f32 (x);
+        i = vaddq_s32 (i, vreinterpretq_s32_u32 (vcgtq_f32 (vcvtq_f32_s32 (i), x)));
+        vst1q_s32 (cell, i);
+        return vsubq_f32 (x, vcvtq_f32_s32 (i));
+    }
+
+#endif
+
+#if defined (PERLIN_SSE2) || defined (PERLIN_NEON)
+
+    static Lanes Fade (Lanes t)
+    {
+        return Mul (Mul (Mul (t, t), t),
+            Add (Mul (t, Sub (Mul (t, Set (6)), Set (15))), Set (10)));
+    }
+
+    static Lanes Lerp (Lanes t, Lanes a, Lanes b)
+    {
+        return Add (a, Mul (t, Sub (b, a)));
+    }
+
+#endif
+
+    // gradient x components and y and z dot product halves of the corners of cell i in the row
+    static void Corners (int i, int j, int jj, int k, int kk, const float yz[4][16],
+        float *gx, float *gyz)
+    {
+        const int A = PERM[i & 0xff], B = PERM[(i + 1) & 0xff];
+        const int AA = PERM[A + j], AB = PERM[A + jj];
+        const int BA = PERM[B + j], BB = PERM[B + jj];
+        const int hash[8] = {
+            PERM[AA + k], PERM[BA + k], PERM[AB + k], PERM[BB + k],
+            PERM[AA + kk], PERM[BA + kk], PERM[AB + kk], PERM[BB + kk]
+        };
+        int32_t c, h;
+
+        // corner c is at i + (c & 1), j + ((c >> 1) & 1), k + (c >> 2)
+        for (c = 0; c < 8; c++) {
+            h = hash[c] & 15;
+            gx[c] = GRAD3[h][0];
+            gyz[c] = yz[c >> 1][h];
+        }
+    }
+
+    static void Row (const float *x, float y, float z, int32_t period, int32_t count,
+        float *n)
+    {
+        int32_t col = 0;
+
+#if defined (PERLIN_SSE2) || defined (PERLIN_NEON)
+        const int j = (int)floorf (y) & 0xff, jj = (j + 1) & 0xff;
+        const int kz = ZCell (z, period);
+        const int k = kz & 0xff, kk = ((kz + 1 < period) ? kz + 1 : 0) & 0xff;
+        const float yy[2] = { y - floorf (y), y - floorf (y) - 1 };
+        const float zz[2] = { z - floorf (z), z - floorf (z) - 1 };
+        const Lanes fy = Set (Fade (yy[0]));
+        const Lanes fz = Set (Fade (zz[0]));
+        float yz[4][16];            // y and z half of the dot product, by corner / 2 and hash
+        float cgx[8], cgyz[8];      // corners of the cell last hashed
+        float gx[8][LANES];         // x component of each lane's corner gradients
+        float gyz[8][LANES];        // y and z half of each lane's corner dot products
+        int32_t cell[LANES];        // floor of x
+        int32_t cached = 0;         // cell last hashed
+        Lanes g[8];
+        int32_t c, h, lane;
+
+        for (c = 0; c < 4; c++) {
+            for (h = 0; h < 16; h++) {
+                yz[c][h] = yy[c & 1] * GRAD3[h][1] + zz[c >> 1] * GRAD3[h][2];
+            }
+        }
+        Corners (cached, j, jj, k, kk, yz, cgx, cgyz);
+
+        for (; col + LANES <= count; col += LANES) {
+
+            // convert each input to a number between 0 and 1
+            const Lanes x0 = Fraction (Load (&x[col]), cell);
+            const Lanes x1 = Sub (x0, Set (1));
+
+            for (lane = 1; (lane < LANES) && (cell[lane] == cell[0]); lane++) {
+            }
+
+            if (lane == LANES) {
+
+                // one cell, broadcast its corners
+                if (cell[0] != cached) {
+                    cached = cell[0];
+                    Corners (cached, j, jj, k, kk, yz, cgx, cgyz);
+                }
+                for (c = 0; c < 8; c++) {
+                    g[c] = Add (Mul ((c & 1) ? x1 : x0, Set (cgx[c])), Set (cgyz[c]));
+                }
+
+            } else {
+
+                // straddles cells, each lane takes its own cell's corners
+                for (lane = 0; lane < LANES; lane++) {
+                    if (cell[lane] != cached) {
+                        cached = cell[lane];
+                        Corners (cached, j, jj, k, kk, yz, cgx, cgyz);
+                    }
+                    for (c = 0; c < 8; c++) {
+                        gx[c][lane] = cgx[c];
+                        gyz[c][lane] = cgyz[c];
+                    }
+                }
+                for (c = 0; c < 8; c++) {
+                    g[c] = Add (Mul ((c & 1) ? x1 : x0, Load (gx[c])), Load (gyz[c]));
+                }
+            }
+
+            // seven linear interpolations
+            const Lanes fx = Fade (x0);
+            Store (&n[col], Lerp (fz, Lerp (fy, Lerp (fx, g[0], g[1]), Lerp (fx, g[2], g[3])),
+                                      Lerp (fy, Lerp (fx, g[4], g[5]), Lerp (fx, g[6], g[7]))));
+        }
+#endif
+
+        for (; col < count; col++) {
+            n[col] = Noise (x[col], y, z, period);
+        }
+    }
+};
+
+
+//---------------------------------------------------------------------------------------------
+// q8.8 -- Row works 8 samples at a time
+//
+// The corners are cached and broadcast the same way as for float. Every result matches
+// Noise () exactly: the lerps are the same integer math, a (4096 - t) + b t, and fit 16 bits
+// after each shift.
+//
+
+struct PerlinQ8_8
+{
+    typedef uint16_t Coord;
+    typedef int32_t Value;
+
+    static const int32_t LANES = 8;
+
+    static Coord Scale (int32_t i, float scale)
+    {
+        return i * (int32_t)(scale * 256.0);
+    }
+
+    static Coord Depth (float z)
+    {
+        return (int32_t)(z * 256.0);
+    }
+
+    static int16_t Grad (const uint8_t h, const int16_t x, const int16_t y, const int16_t z)
+    {
+        return x * GRAD3[h][0] + y * GRAD3[h][1] + z * GRAD3[h][2];
+    }
+
+    // integer part of z wrapped at the period, and the cell after it
+    static void ZCells (uint16_t z, int32_t period, uint8_t *k0, uint8_t *k1)
+    {
+        *k0 = (z >> 8) % period;
+        *k1 = (*k0 + 1 < period) ? *k0 + 1 : 0;
+    }
+
+    static Value Noise (uint16_t x, uint16_t y, uint16_t z, int32_t period)
+    {
+        uint8_t i0, j0, k0;     // integer part of (x, y, z)
+        uint8_t i1, j1, k1;     // integer part plus one of (x, y, z)
+        uint8_t xx, yy, zz;     // fractional part of (x, y, z)
+        uint16_t fx, fy, fz;    // easing function result, add 4 LS bits
+
+        // drop fractional part of each input
+        i0 = x >> 8;
+        j0 = y >> 8;
+
+        // integer part plus one, wrapped between 0x00 and 0xff
+        i1 = i0 + 1;
+        j1 = j0 + 1;
+
+        // z wraps at its period instead
+        ZCells (z, period, &k0, &k1);
+
+        // fractional part of each input
+        xx = x & 0xff;
+        yy = y & 0xff;
+        zz = z & 0xff;
+
+        // apply easing function
+        fx = easing_function_lut[xx];
+        fy = easing_function_lut[yy];
+        fz = easing_function_lut[zz];
+
+        uint8_t A, AA, AB, B, BA, BB;
+        uint8_t CA, CB, CC, CD, CE, CF, CG, CH;
+
+        // apply permutation functions
+        A = PERM[i0];
+        AA = PERM[A + j0];
+        AB = PERM[A + j1];
+        B = PERM[i1];
+        BA = PERM[B + j0];
+        BB = PERM[B + j1];
+        CA = PERM[AA + k0] & 0xf;
+        CB = PERM[BA + k0] & 0xf;
+        CC = PERM[AB + k0] & 0xf;
+        CD = PERM[BB + k0] & 0xf;
+        CE = PERM[AA + k1] & 0xf;
+        CF = PERM[BA + k1] & 0xf;
+        CG = PERM[AB + k1] & 0xf;
+        CH = PERM[BB + k1] & 0xf;
+
+        // subtract 1.0 from xx, yy, zz
+        int16_t xxm1 = xx - 256;
+        int16_t yym1 = yy - 256;
+        int16_t zzm1 = zz - 256;
+
+        // result is -2 to exactly +2
+        int16_t g1 = Grad (CA, xx,   yy,   zz  );
+        int16_t g2 = Grad (CB, xxm1, yy,   zz  );
+        int16_t g3 = Grad (CC, xx,   yym1, zz  );
+        int16_t g4 = Grad (CD, xxm1, yym1, zz  );
+        int16_t g5 = Grad (CE, xx,   yy,   zzm1);
+        int16_t g6 = Grad (CF, xxm1, yy,   zzm1);
+        int16_t g7 = Grad (CG, xx,   yym1, zzm1);
+        int16_t g8 = Grad (CH, xxm1, yym1, zzm1);
+
+        // linear interpolations
+        int32_t l1 = lerp1(fx, g1, g2) >> 6;
+        int32_t l2 = lerp1(fx, g3, g4) >> 6;
+        int32_t l3 = lerp1(fx, g5, g6) >> 6;
+        int32_t l4 = lerp1(fx, g7, g8) >> 6;
+
+        int32_t l5 = lerp1(fy, l1, l2) >> 12;
+        int32_t l6 = lerp1(fy, l3, l4) >> 12;
+
+        int32_t l7 = lerp1(fz, l5, l6) >> 12;
+
+        return l7;
+    }
+
+#if defined (PERLIN_SSE2)
+
+    typedef __m128i Lanes;
+
+    static Lanes Load (const int16_t *p)
+    {
+        return _mm_loadu_si128 ((const __m128i *)p);
+    }
+
+    static Lanes Set (int16_t a)
+    {
+        return _mm_set1_epi16 (a);
+    }
+
+    static Lanes Add (Lanes a, Lanes b)
+    {
+        return _mm_add_epi16 (a, b);
+    }
+
+    static Lanes Sub (Lanes a, Lanes b)
+    {
+        return _mm_sub_epi16 (a, b);
+    }
+
+    static Lanes Mul (Lanes a, Lanes b)
+    {
+        return _mm_mullo_epi16 (a, b);
+    }
+
+    // (a (4096 - t) + b t) >> shift, the products interleaved for the multiply-adds
+    static Lanes Lerp (Lanes t, Lanes a, Lanes b, int32_t shift)
+    {
+        const Lanes s = _mm_sub_epi16 (_mm_set1_epi16 (4096), t);
+        const __m128i count = _mm_cvtsi32_si128 (shift);
+        __m128i lo = _mm_madd_epi16 (_mm_unpacklo_epi16 (a, b), _mm_unpacklo_epi16 (s, t));
+        __m128i hi = _mm_madd_epi16 (_mm_unpackhi_epi16 (a, b), _mm_unpackhi_epi16 (s, t));
+        return _mm_packs_epi32 (_mm_sra_epi32 (lo, count), _mm_sra_epi32 (hi, count));
+    }
+
+    static void Store (int32_t *p, Lanes a)
+    {
+        _mm_storeu_si128 ((__m128i *)&p[0], _mm_srai_epi32 (_mm_unpacklo_epi16 (a, a), 16));
+        _mm_storeu_si128 ((__m128i *)&p[4], _mm_srai_epi32 (_mm_unpackhi_epi16 (a, a), 16));
+    }
+
+#elif defined (PERLIN_NEON)
+
+    typedef int16x8_t Lanes;
+
+    static Lanes Load (const int16_t *p)
+    {
+        return vld1q_s16 (p);
+    }
+
+    static Lanes Set (int16_t a)
+    {
+        return vdupq_n_s16 (a);
+    }
+
+    static Lanes Add (Lanes a, Lanes b)
+    {
+        return vaddq_s16 (a, b);
+    }
+
+    static Lanes Sub (Lanes a, Lanes b)
+    {
+        return vsubq_s16 (a, b);
+    }
+
+    static Lanes Mul (Lanes a, Lanes b)
+    {
+        return vmulq_s16 (a, b);
+    }
+
+    // (a (4096 - t) + b t) >> shift, a shift left by a negative count shifts right
+    static Lanes Lerp (Lanes t, Lanes a, Lanes b, int32_t shift)
+    {
+        const Lanes s = vsubq_s16 (vdupq_n_s16 (4096), t);
+        const int32x4_t count = vdupq_n_s32 (-shift);
+        int32x4_t lo = vmlal_s16 (vmull_s16 (vget_low_s16 (a), vget_low_s16 (s)),
+            vget_low_s16 (b), vget_low_s16 (t));
+        int32x4_t hi = vmlal_s16 (vmull_s16 (vget_high_s16 (a), vget_high_s16 (s)),
+            vget_high_s16 (b), vget_high_s16 (t));
+        return vcombine_s16 (vmovn_s32 (vshlq_s32 (lo, count)),
+            vmovn_s32 (vshlq_s32 (hi, count)));
+    }
+
+    static void Store (int32_t *p, Lanes a)
+    {
+        vst1q_s32 (&p[0], vmovl_s16 (vget_low_s16 (a)));
+        vst1q_s32 (&p[4], vmovl_s16 (vget_high_s16 (a)));
+    }
+
+#endif
+
+    // gradient x components and y and z dot product halves of the corners of cell i0
+    static void Corners (uint8_t i0, uint8_t j0, uint8_t j1, uint8_t k0, uint8_t k1,
+        const int16_t yz[4][16], int16_t *gx, int16_t *gyz)
+    {
+        const uint8_t i1 = i0 + 1;
+        const uint8_t A = PERM[i0], B = PERM[i1];
+        const uint8_t AA = PERM[A + j0], AB = PERM[A + j1];
+        const uint8_t BA = PERM[B + j0], BB = PERM[B + j1];
+        const uint8_t hash[8] = {
+            PERM[AA + k0], PERM[BA + k0], PERM[AB + k0], PERM[BB + k0],
+            PERM[AA + k1], PERM[BA + k1], PERM[AB + k1], PERM[BB + k1]
+        };
+        int32_t c, h;
+
+        // corner c is at i0 + (c & 1), j0 + ((c >> 1) & 1), k0 + (c >> 2)
+        for (c = 0; c < 8; c++) {
+            h = hash[c] & 0xf;
+            gx[c] = GRAD3[h][0];
+            gyz[c] = yz[c >> 1][h];
+        }
+    }
+
+    static void Row (const uint16_t *x, uint16_t y, uint16_t z, int32_t period,
+        int32_t count, int32_t *n)
+    {
+        int32_t col = 0;
+
+#if defined (PERLIN_SSE2) || defined (PERLIN_NEON)
+        const uint8_t j0 = y >> 8, j1 = j0 + 1;
+        uint8_t k0, k1;
+        const int16_t yy[2] = { (int16_t)(y & 0xff), (int16_t)((y & 0xff) - 256) };
+        const int16_t zz[2] = { (int16_t)(z & 0xff), (int16_t)((z & 0xff) - 256) };
+        const Lanes fy = Set (easing_function_lut[y & 0xff]);
+        const Lanes fz = Set (easing_function_lut[z & 0xff]);
+        int16_t yz[4][16];              // y and z half of the dot product, by corner / 2, hash
+        int16_t cgx[8], cgyz[8];        // corners of the cell last hashed
+        int16_t gx[8][LANES];           // x component of each lane's corner gradients
+        int16_t gyz[8][LANES];          // y and z half of each lane's corner dot products
+        int16_t xx[LANES], fx[LANES];   // fractional part of x and its easing
+        uint8_t cell[LANES];            // integer part of x
+        uint8_t cached = 0;             // cell last hashed
+        Lanes g[8];
+        int32_t c, h, lane;
+
+        ZCells (z, period, &k0, &k1);
+        for (c = 0; c < 4; c++) {
+            for (h = 0; h < 16; h++) {
+                yz[c][h] = yy[c & 1] * GRAD3[h][1] + zz[c >> 1] * GRAD3[h][2];
+            }
+        }
+        Corners (cached, j0, j1, k0, k1, yz, cgx, cgyz);
+
+        for (; col + LANES <= count; col += LANES) {
+
+            // split each input and apply the easing function
+            for (lane = 0; lane < LANES; lane++) {
+                cell[lane] = x[col + lane] >> 8;
+                xx[lane] = x[col + lane] & 0xff;
+                fx[lane] = easing_function_lut[xx[lane]];
+            }
+
+            // result is -2 to exactly +2
+            const Lanes x0 = Load (xx);
+            const Lanes x1 = Sub (x0, Set (256));
+
+            for (lane = 1; (lane < LANES) && (cell[lane] == cell[0]); lane++) {
+            }
+
+            if (lane == LANES) {
+
+                // one cell, broadcast its corners
+                if (cell[0] != cached) {
+                    cached = cell[0];
+                    Corners (cached, j0, j1, k0, k1, yz, cgx, cgyz);
+                }
+                for (c = 0; c < 8; c++) {
+                    g[c] = Add (Mul ((c & 1) ? x1 : x0, Set (cgx[c])), Set (cgyz[c]));
+                }
+
+            } else {
+
+                // straddles cells, each lane takes its own cell's corners
+                for (lane = 0; lane < LANES; lane++) {
+                    if (cell[lane] != cached) {
+                        cached = cell[lane];
+                        Corners (cached, j0, j1, k0, k1, yz, cgx, cgyz);
+                    }
+                    for (c = 0; c < 8; c++) {
+                        gx[c][lane] = cgx[c];
+                        gyz[c][lane] = cgyz[c];
+                    }
+                }
+                for (c = 0; c < 8; c++) {
+                    g[c] = Add (Mul ((c & 1) ? x1 : x0, Load (gx[c])), Load (gyz[c]));
+                }
+            }
+
+            // linear interpolations
+            const Lanes t = Load (fx);
+            Lanes l1 = Lerp (t, g[0], g[1], 6);
+            Lanes l2 = Lerp (t, g[2], g[3], 6);
+            Lanes l3 = Lerp (t, g[4], g[5], 6);
+            Lanes l4 = Lerp (t, g[6], g[7], 6);
+
+            Lanes l5 = Lerp (fy, l1, l2, 12);
+            Lanes l6 = Lerp (fy, l3, l4, 12);
+
+            Store (&n[col], Lerp (fz, l5, l6, 12));
+        }
+#endif
+
+        for (; col < count; col++) {
+            n[col] = Noise (x[col], y, z, period);
+        }
+    }
+};
+
+
+//---------------------------------------------------------------------------------------------
+// q16.16 -- the finest lattice steps, one sample at a time
+//
+// The 16-bit fraction is too wide for an easing table or 16-bit lanes, so the fade is worked
+// out with 64-bit products and the lerps are a + ((t (b - a)) >> 16). The noise comes out in
+// Q16, with 16 integer bits of z the period can reach 65536 cells.
+//
+
+struct PerlinQ16_16
+{
+    typedef uint32_t Coord;
+    typedef int32_t Value;
+
+    static Coord Scale (int32_t i, float scale)
+    {
+        return (uint32_t)i * (uint32_t)(int32_t)(scale * 65536.0);
+    }
+
+    static Coord Depth (float z)
+    {
+        return (int32_t)(z * 65536.0);
+    }
+
+    static int32_t Grad (const uint8_t h, const int32_t x, const int32_t y, const int32_t z)
+    {
+        return x * GRAD3[h][0] + y * GRAD3[h][1] + z * GRAD3[h][2];
+    }
+
+    // integer part of z wrapped at the period, and the cell after it, both within the table
+    static void ZCells (uint32_t z, int32_t period, uint8_t *k0, uint8_t *k1)
+    {
+        const int32_t k = (z >> 16) % period;
+
+        *k0 = k;
+        *k1 = (k + 1 < period) ? k + 1 : 0;
+    }
+
+    // 6t^5 - 15t^4 + 10t^3 of a Q16 fraction, rounded down to Q16
+    static int32_t Fade (int64_t t)
+    {
+        int64_t f = ((t * (t * 6 - (15 << 16))) >> 16) + (10 << 16);
+
+        f = (t * f) >> 16;
+        f = (t * f) >> 16;
+        return (t * f) >> 16;
+    }
+
+    static int32_t Lerp (int32_t t, int32_t a, int32_t b)
+    {
+        return a + (int32_t)(((int64_t)t * (b - a)) >> 16);
+    }
+
+    static Value Noise (uint32_t x, uint32_t y, uint32_t z, int32_t period)
+    {
+        const uint8_t i0 = x >> 16, i1 = i0 + 1;
+        const uint8_t j0 = y >> 16, j1 = j0 + 1;
+        uint8_t k0, k1;
+
+        ZCells (z, period, &k0, &k1);
+
+        // fractional part of each input, and the fraction minus one
+        const int32_t xx = x & 0xffff, xxm1 = xx - 65536;
+        const int32_t yy = y & 0xffff, yym1 = yy - 65536;
+        const int32_t zz = z & 0xffff, zzm1 = zz - 65536;
+        const int32_t fx = Fade (xx), fy = Fade (yy), fz = Fade (zz);
+
+        // apply permutation functions
+        const uint8_t A = PERM[i0], B = PERM[i1];
+        const uint8_t AA = PERM[A + j0], AB = PERM[A + j1];
+        const uint8_t BA = PERM[B + j0], BB = PERM[B + j1];
+
+        // linear interpolations
+        return Lerp (fz,
+            Lerp (fy, Lerp (fx, Grad (PERM[AA + k0] & 0xf, xx,   yy,   zz),
+                                Grad (PERM[BA + k0] & 0xf, xxm1, yy,   zz)),
+                      Lerp (fx, Grad (PERM[AB + k0] & 0xf, xx,   yym1, zz),
+                                Grad (PERM[BB + k0] & 0xf, xxm1, yym1, zz))),
+            Lerp (fy, Lerp (fx, Grad (PERM[AA + k1] & 0xf, xx,   yy,   zzm1),
+                                Grad (PERM[BA + k1] & 0xf, xxm1, yy,   zzm1)),
+                      Lerp (fx, Grad (PERM[AB + k1] & 0xf, xx,   yym1, zzm1),
+                                Grad (PERM[BB + k1] & 0xf, xxm1, yym1, zzm1))));
+    }
+
+    static void Row (const uint32_t *x, uint32_t y, uint32_t z, int32_t period,
+        int32_t count, int32_t *n)
+    {
+        for (int32_t col = 0; col < count; col++) {
+            n[col] = Noise (x[col], y, z, period);
+        }
+    }
+};
@@ -43,6 +43,17 @@
 #ifndef __perlin_h_
 #define __perlin_h_
 
+// numbers the noise is worked out in, see perlin.cpp
+//   PERLIN_FLOAT  = float coordinates and noise, 4 samples at a time with SSE2 or NEON
+//   PERLIN_Q8_8   = 8.8 fixed point coordinates, 8 samples at a time with SSE2 or NEON
+//   PERLIN_Q16_16 = 16.16 fixed point coordinates, one sample at a time
+enum PerlinNumeric {
+    PERLIN_FLOAT,
+    PERLIN_Q8_8,
+    PERLIN_Q16_16,
+    PERLIN_NUMERICS
+};
+
 class Perlin : public Pattern
 {
     public:
@@ -90,6 +101,18 @@ class Perlin : public Pattern
             m_z_state = 0;                  
         }
 
+        // get / set looping
+        // looping noise repeats in z after the z depth rounded to whole lattice cells, at
+        // most as many as the numbers' integer part of z reaches, 256 for q8.8, so each pixel
+        // takes one noise evaluation instead of two planes crossfaded together
+        bool getLoop (void) {
+            return m_loop;
+        }
+        void setLoop (bool loop) {
+            m_loop = loop;
+            m_z_state = 0;
+        }
+
         // get / set hue options
         float getHueOptions (void) {
             return m_hue_options;
@@ -98,10 +121,33 @@ class Perlin : public Pattern
             m_hue_options = hue_options;
         }
 
+        // get / set the numbers the noise is worked out in, by default the fastest on this
+        // cpu or the one the PERLIN_NUMERIC environment variable names: float, q8.8 or q16.16
+        PerlinNumeric getNumeric (void) {
+            return m_numeric;
+        }
+        void setNumeric (PerlinNumeric numeric);
+
+    protected:
+
+        // noise for the band's rows on pass 0, colors on pass 1
+        void renderBand (int32_t pass, int32_t band, int32_t first, int32_t count);
+
     private:
 
-        // 3d perlin noise function
-        float noise (float x, float y, float z);
+        // point m_drawBand at the loop for m_mode and pick the fastest numbers
+        void specialize (void);
+
+        // noise for count rows from first into m_noise, and their extremes, worked out in
+        // the numbers of policy N
+        template <class N> void noiseBand (int32_t band, int32_t first, int32_t count);
+
+        // normalize and draw count rows from first, the loop specialized for MODE
+        template <int32_t MODE> void drawBand (int32_t band, int32_t first, int32_t count);
+
+        // the noise and draw loops for m_numeric and m_mode
+        void (Perlin::*m_noiseBand) (int32_t band, int32_t first, int32_t count);
+        void (Perlin::*m_drawBand) (int32_t band, int32_t first, int32_t count);
 
         // mode:
         //   1 = fixed background hue
@@ -122,6 +168,12 @@ class Perlin : public Pattern
         // hue step size for modes 2 and 3
         float m_hue_options;
 
+        // noise repeats after the z depth instead of crossfading two planes
+        bool m_loop;
+
+        // numbers the noise is worked out in
+        PerlinNumeric m_numeric;
+
         // current z coordinate, mod z depth
         float m_z_state;
     
@@ -130,6 +182,15 @@ class Perlin : public Pattern
         
         // current minimum and maximum noise values for normalization
         float m_min, m_max;
+
+        // the frame's z period in lattice cells and z depth
+        int32_t m_period;
+        float m_depth;
+
+        // the frame's combined noise, and the extremes of each band until the bands are
+        // drawn, when they hold the minimum and maximum each band's normalization starts from
+        float m_noise[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+        float m_bandMin[TILE_BANDS], m_bandMax[TILE_BANDS];
 };
 
 #endif
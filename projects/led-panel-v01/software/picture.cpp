@@ -13,25 +13,24 @@
 #include <signal.h>
 #include <memory.h>
 
+#include "fpga.h"
 #include "gammalut.h"
 
-void write16 (uint16_t addr, uint16_t data);
-
-int fd = 0;
-
 int main (int argc, char *argv[])
 {
     // open fpga memory device
-    fd = open ("/dev/logibone_mem", O_RDWR | O_SYNC);
+    if (!FpgaOpen ()) {
+        return -1;
+    }
 
     // open raw image data
     FILE *fin = fopen (argv[1], "rb");
 
     // set address to buffer 0
-    write16 (0x0010, 0x0000);
+    Write16 (FPGA_PANEL_ADDR_REG, 0x0000);
 
     // display buffer 0
-    write16 (0x0014, 0x0000);
+    Write16 (FPGA_PANEL_BUFFER_REG, 0x0000);
 
     // read image data from file and write to display
     for (int row = 0; row < 32; row++) {
@@ -43,7 +42,7 @@ int main (int argc, char *argv[])
             g = gammaLut[g];
             b = gammaLut[b];
             uint16_t data = (r<<8) | (g<<4) | b;
-            write16 (0x0012, data);
+            Write16 (FPGA_PANEL_DATA_REG, data);
         }
     }
     
@@ -51,13 +50,7 @@ int main (int argc, char *argv[])
     fclose (fin);
 
     // close fpga device
-    close (fd);
+    FpgaClose ();
 
     return 0;
 }
-
-
-void write16 (uint16_t addr, uint16_t data)
-{
-    pwrite (fd, &data, 2, addr);
-}
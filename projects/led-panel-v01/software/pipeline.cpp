@@ -0,0 +1,518 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "globals.h"
+#include "fpga.h"
+#include "triplebuffer.h"
+#include "delta.h"
+#include "dither.h"
+#include "palette.h"
+#include "calibrate.h"
+#include "dimming.h"
+#include "power.h"
+#include "frameloop.h"
+#include "stats.h"
+#include "tiles.h"
+#include "pipeline.h"
+
+// FPGA frame buffer select
+static int32_t gBuffer = 0;
+
+// set when the bitstream reports which buffer it is scanning out
+static int32_t gSync = -1;
+
+// give up waiting for a buffer swap after this long, a refresh takes about 6 msec
+// the co-simulation overrides it since simulating a refresh takes far longer than that
+#ifndef SWAP_TIMEOUT_NSEC
+#define SWAP_TIMEOUT_NSEC 50000000
+#endif
+#define SWAP_POLL_NSEC      100000
+
+// frames handed from the render thread to the present thread
+static TripleBuffer gFrames;
+
+// tracks what each FPGA buffer holds so only changed pixels are uploaded
+static DeltaEncoder gDelta;
+
+// quantize linear frames when the pattern draws them
+static TemporalDither gTemporal;
+static OrderedDither gOrdered;
+static Frame gDithered;
+
+// levels of the newest palette indexed frame
+static Frame gMapped;
+
+// per panel color correction when loaded, linear frames before quantizing, levels after
+static PanelCalibration gCalibration;
+static LinearFrame gCalibrated;
+static Frame gCorrected;
+
+// scales dim linear frames up, and the dimming register value the FPGA has now
+static DimmingControl gDimming;
+static uint16_t gLevel = DIMMING_FULL;
+
+// keeps the supply current of every upload within the configured budgets
+static PowerLimit gPower;
+
+// threads
+static pthread_t gRenderThread;
+static pthread_t gPresentThread;
+static volatile bool gRunning = false;
+
+// frame rate, priority and missed deadline policy
+static FrameLoopConfig gConfig;
+
+// program's render function
+static void (*gRender) (void) = NULL;
+
+// prototypes
+static void UploadFrame (const Frame *frame, uint16_t level);
+static const LinearFrame *Calibrate (const LinearFrame *frame);
+static const Frame *Calibrate (const Frame *frame);
+static void *RenderThread (void *arg);
+static void *PresentThread (void *arg);
+static int32_t IdleBuffer (void);
+static int64_t WaitForSwap (uint16_t *status);
+
+
+//---------------------------------------------------------------------------------------------
+// start the render and present threads
+//
+
+bool PipelineStart (void (*render) (void), const FrameLoopConfig *config)
+{
+    sigset_t block, old;
+
+    gRender = render;
+    gConfig = *config;
+    gRunning = true;
+
+    gTemporal.reset ();
+    gDimming.reset ();
+    gPower.setBudget (gConfig.panelBudget, gConfig.totalBudget, gConfig.dimming);
+
+    if ((gConfig.calibration != NULL) && !gCalibration.load (gConfig.calibration)) {
+        gRunning = false;
+        return false;
+    }
+
+    StatsSetTestPin (gConfig.testPin);
+
+    // keep ctrl-c and other signals on the main thread, the new threads inherit this mask
+    sigfillset (&block);
+    pthread_sigmask (SIG_BLOCK, &block, &old);
+
+    if ((gConfig.statsSocket != NULL) && !StatsStartServer (gConfig.statsSocket)) {
+        pthread_sigmask (SIG_SETMASK, &old, NULL);
+        gRunning = false;
+        return false;
+    }
+
+    // helpers for the render thread to draw banded patterns with
+    if (!TilesStart (gConfig.threads)) {
+        pthread_sigmask (SIG_SETMASK, &old, NULL);
+        gRunning = false;
+        StatsStopServer ();
+        return false;
+    }
+
+    if (pthread_create (&gRenderThread, NULL, RenderThread, NULL) != 0) {
+        pthread_sigmask (SIG_SETMASK, &old, NULL);
+        gRunning = false;
+        TilesStop ();
+        StatsStopServer ();
+        return false;
+    }
+
+    if (pthread_create (&gPresentThread, NULL, PresentThread, NULL) != 0) {
+        pthread_sigmask (SIG_SETMASK, &old, NULL);
+        gRunning = false;
+        pthread_join (gRenderThread, NULL);
+        TilesStop ();
+        StatsStopServer ();
+        return false;
+    }
+
+    pthread_sigmask (SIG_SETMASK, &old, NULL);
+
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// stop and join the render and present threads, each exits at its next frame deadline
+//
+
+void PipelineStop (void)
+{
+    if (!gRunning) {
+        return;
+    }
+
+    gRunning = false;
+    pthread_join (gRenderThread, NULL);
+    pthread_join (gPresentThread, NULL);
+    TilesStop ();
+
+    // leave the panels at full level for whatever runs next
+    if (gLevel != DIMMING_FULL) {
+        Write16 (FPGA_PANEL_DIMMING_REG, DIMMING_FULL);
+        gLevel = DIMMING_FULL;
+    }
+
+    StatsStopServer ();
+    StatsSetTestPin (STATS_TEST_PIN_OFF);
+}
+
+
+//---------------------------------------------------------------------------------------------
+// buffer swap counter from the FPGA, increments at the end of each refresh that swapped
+// buffers, zero if the bitstream doesn't have it
+//
+
+uint16_t PipelineGetSwapCount (void)
+{
+    if (gSync <= 0) {
+        return 0;
+    }
+
+    return Read16 (FPGA_PANEL_SWAP_COUNT_REG);
+}
+
+
+//---------------------------------------------------------------------------------------------
+// upload gLevels from the calling thread
+//
+
+void WriteLevels (void)
+{
+    static Frame frame;
+
+    memcpy (frame.levels, gLevels, sizeof (frame.levels));
+    UploadFrame (&frame, DIMMING_FULL);
+}
+
+
+//---------------------------------------------------------------------------------------------
+// threads
+//
+
+static void *RenderThread (void *arg)
+{
+    FrameClock clock (gConfig.fps);
+    int32_t elapsed, frames;
+    int64_t start;
+
+    FrameLoopSetThread (&gConfig, gConfig.priority);
+
+    clock.start ();
+    while (1) {
+        elapsed = clock.wait ();
+        if (!gRunning) {
+            break;
+        }
+
+        // after an overrun either render the missed frames too, keeping animation time,
+        // or skip them and carry on from here
+        frames = 1;
+        if (elapsed > 1) {
+            StatsCount (STATS_MISSED_DEADLINES, elapsed - 1);
+            if (gConfig.policy == FRAME_LOOP_CATCH_UP) {
+                frames = (elapsed < gConfig.maxCatchUp) ? elapsed : gConfig.maxCatchUp;
+            }
+            StatsCount (STATS_DROPPED_FRAMES, elapsed - frames);
+        }
+
+        start = StatsBegin (STATS_RENDER);
+
+        // calculate next frame in animation
+        StatsCount (STATS_FRAMES_RENDERED, frames);
+        while (frames-- > 0) {
+            gRender ();
+        }
+
+        // hand it to the present thread
+        if (gConfig.quantize == QUANTIZE_NONE) {
+            memcpy (gFrames.back ()->levels, gLevels, sizeof (gLevels));
+        } else if (gConfig.quantize == QUANTIZE_PALETTE) {
+            IndexedFrame *indexed = gFrames.backIndexed ();
+            memcpy (indexed->indices, gIndices, sizeof (gIndices));
+            memcpy (indexed->palette, gPalette, sizeof (gPalette));
+            indexed->rotate = gPaletteRotate;
+        } else {
+            memcpy (gFrames.backLinear ()->linear, gLinear, sizeof (gLinear));
+        }
+        gFrames.publish ();
+
+        StatsEnd (STATS_RENDER, start);
+    }
+
+    return NULL;
+}
+
+
+static void *PresentThread (void *arg)
+{
+    FrameClock clock (gConfig.fps);
+    const LinearFrame *linear = NULL;
+    int64_t start;
+    bool fresh;
+
+    // uploads preempt rendering on a single core
+    FrameLoopSetThread (&gConfig, (gConfig.priority > 0) ? gConfig.priority + 1 : 0);
+
+    clock.start ();
+    while (1) {
+        // deadlines missed during a slow upload are covered by this one upload
+        clock.wait ();
+        if (!gRunning) {
+            break;
+        }
+
+        // write newest levels to display, keep showing the last frame if nothing new
+        switch (gConfig.quantize) {
+            case QUANTIZE_NONE:
+                if (gFrames.acquire ()) {
+                    UploadFrame (Calibrate (gFrames.front ()), DIMMING_FULL);
+                }
+                break;
+
+            // dithered levels change every period, so requantize the newest frame either way
+            case QUANTIZE_TEMPORAL:
+                fresh = gFrames.acquire ();
+                start = StatsBegin (STATS_QUANTIZE);
+                if (fresh || (linear == NULL)) {
+                    linear = Calibrate (gFrames.frontLinear ());
+                }
+                if (fresh && gConfig.dimming) {
+                    gDimming.update (linear);
+                }
+                gTemporal.quantize (linear, &gDithered, gDimming.getShift ());
+                StatsEnd (STATS_QUANTIZE, start);
+                UploadFrame (&gDithered, gDimming.getLevel ());
+                break;
+
+            case QUANTIZE_ORDERED:
+                if (gFrames.acquire ()) {
+                    start = StatsBegin (STATS_QUANTIZE);
+                    linear = Calibrate (gFrames.frontLinear ());
+                    if (gConfig.dimming) {
+                        gDimming.update (linear);
+                    }
+                    gOrdered.quantize (linear, &gDithered, gDimming.getShift ());
+                    StatsEnd (STATS_QUANTIZE, start);
+                    UploadFrame (&gDithered, gDimming.getLevel ());
+                }
+                break;
+
+            case QUANTIZE_PALETTE:
+                if (gFrames.acquire ()) {
+                    const IndexedFrame *indexed = gFrames.frontIndexed ();
+                    start = StatsBegin (STATS_QUANTIZE);
+                    PaletteMap (&indexed->indices[0][0], indexed->palette, indexed->rotate,
+                        &gMapped.levels[0][0]);
+                    if (gCalibration.isLoaded ()) {
+                        gCalibration.apply (&gMapped, &gMapped);
+                    }
+                    StatsEnd (STATS_QUANTIZE, start);
+                    UploadFrame (&gMapped, DIMMING_FULL);
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return NULL;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// correct a linear frame for each panel's white point when a calibration is loaded, the
+// corrected copy stays valid until the next call
+//
+
+static const LinearFrame *Calibrate (const LinearFrame *frame)
+{
+    if (!gCalibration.isLoaded ()) {
+        return frame;
+    }
+
+    gCalibration.apply (frame, &gCalibrated);
+
+    return &gCalibrated;
+}
+
+
+// same for levels, through each panel's table
+static const Frame *Calibrate (const Frame *frame)
+{
+    if (!gCalibration.isLoaded ()) {
+        return frame;
+    }
+
+    gCalibration.apply (frame, &gCorrected);
+
+    return &gCorrected;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// wait for the FPGA to be scanning out the buffer software selected
+//
+// The matrix controller only picks up a new buffer select at the end of a refresh. Until
+// then it keeps scanning out the old buffer. Returns how long the wait took in nsec, or -1
+// if the swap didn't happen within the timeout.
+//
+
+static int64_t WaitForSwap (uint16_t *status)
+{
+    struct timespec poll;
+    int64_t start;
+
+    poll.tv_sec = 0;
+    poll.tv_nsec = SWAP_POLL_NSEC;
+    start = FrameClock::now ();
+
+    while (1) {
+        *status = Read16 (FPGA_PANEL_STATUS_REG);
+
+        // scanning the selected buffer, the other one is idle
+        if (((*status & FPGA_PANEL_STATUS_SELECTED) != 0) ==
+                ((*status & FPGA_PANEL_STATUS_CURRENT) != 0)) {
+            return FrameClock::now () - start;
+        }
+
+        if (FrameClock::now () - start >= SWAP_TIMEOUT_NSEC) {
+            StatsCount (STATS_SWAP_TIMEOUTS, 1);
+            return -1;
+        }
+
+        nanosleep (&poll, NULL);
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// find a buffer that is safe to write
+//
+// Bitstreams without the status register fall back to alternating blindly.
+//
+
+static int32_t IdleBuffer (void)
+{
+    uint16_t status;
+
+    if (gSync < 0) {
+        gSync = FpgaHasStatus () ? 1 : 0;
+    }
+
+    if (gSync == 0) {
+        return gBuffer;
+    }
+
+    // normally the swap was already seen right after the previous upload
+    WaitForSwap (&status);
+
+    return (status & FPGA_PANEL_STATUS_CURRENT) ? 0 : 1;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// write a frame to the inactive FPGA buffer and make it active, then set the dimming level
+// it was scaled for, or lower when that keeps it within the current budget
+//
+
+static void UploadFrame (const Frame *frame, uint16_t level)
+{
+    int32_t spans, i;
+    int64_t start, swap;
+    uint16_t status;
+
+    start = StatsBegin (STATS_UPLOAD);
+
+    // estimate the frame as it will be shown and bring it within budget
+    frame = gPower.limit (frame, &level);
+    StatsSetGauge (STATS_POWER_DEMAND_MA, gPower.getDemand ());
+    StatsSetGauge (STATS_POWER_MA, gPower.getPower ());
+    StatsSetGauge (STATS_PANEL_POWER_MA, gPower.getPanelPeak ());
+    if (gPower.getPower () < gPower.getDemand ()) {
+        StatsCount (STATS_POWER_LIMITED, 1);
+    }
+
+    // don't write into the buffer that's still on the display
+    gBuffer = IdleBuffer ();
+
+    // plan writes to the selected buffer, a full frame if most of it changed
+    spans = gDelta.encode (gBuffer, frame);
+
+    // write data to selected buffer, the address auto increments so it only needs
+    // to be set again where a run doesn't follow on from the previous one
+    const DeltaSpan *span = gDelta.getSpans ();
+    for (i = 0; i < spans; i++, span++) {
+        if (span->setAddress) {
+            Write16 (FPGA_PANEL_ADDR_REG, span->address);
+        }
+        WriteBurst16 (FPGA_PANEL_DATA_REG, &frame->levels[span->row][span->col], span->count);
+    }
+
+    gDelta.commit (gBuffer, frame);
+
+    // make that buffer active
+    if (gBuffer == 0) {
+        Write16 (FPGA_PANEL_BUFFER_REG, 0x0000);
+        gBuffer = 1;
+    } else {
+        Write16 (FPGA_PANEL_BUFFER_REG, 0x0001);
+        gBuffer = 0;
+    }
+
+    StatsEnd (STATS_UPLOAD, start);
+    StatsCount (STATS_FRAMES_PRESENTED, 1);
+    StatsCount (STATS_BUS_WRITES, gDelta.getWrites () + 1);
+
+    // time from present to the frame actually appearing
+    if (gSync > 0) {
+        swap = WaitForSwap (&status);
+        if (swap >= 0) {
+            StatsRecord (STATS_SWAP, swap);
+        }
+    }
+
+    // the level changes as close as the poll gets to the swap, so the old frame at the
+    // new level shows for a fraction of one refresh at most
+    if (level != gLevel) {
+        Write16 (FPGA_PANEL_DIMMING_REG, level);
+        gLevel = level;
+        StatsCount (STATS_BUS_WRITES, 1);
+    }
+}
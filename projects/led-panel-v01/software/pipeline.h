@@ -0,0 +1,59 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#ifndef __pipeline_h_
+#define __pipeline_h_
+
+// The frame pipeline splits each frame period into two threads that share a triple buffer,
+// both woken at absolute frame deadlines by a FrameClock. The render thread calls the
+// program's render function to draw the next frame into gLevels and publishes a copy. The
+// present thread uploads whichever published frame is newest, so a slow frame never delays
+// an upload and rendering overlaps with the GPMC transfer. On bitstreams with the buffer
+// status register an upload first waits for the FPGA to finish swapping to the previous
+// frame, so the buffer being written is never on the display.
+// Patterns that draw gLinear instead of gLevels publish linear frames, and the present
+// thread quantizes the newest one to levels with the quantizer picked in the config.
+// Patterns that draw palette indices publish them with their palette, and the present
+// thread maps the newest ones to levels, see palette.h.
+// Every frame goes through the per panel color correction when a calibration is loaded,
+// linear ones before they are quantized, see calibrate.h.
+// With dimming on, dim linear frames are scaled up before quantizing and the FPGA's dimming
+// register brought down to match, see dimming.h.
+// Every upload is estimated for supply current and scaled down to the budgets, see power.h.
+// Patterns that draw in bands spread them over the tile threads started with the pipeline,
+// see tiles.h.
+// Timings and counters for every stage are recorded in stats.h.
+
+// start the render and present threads with the given frame rate and scheduling
+// render is called once per frame from the render thread and draws the next frame in gLevels
+bool PipelineStart (void (*render) (void), const FrameLoopConfig *config);
+
+// stop and join the render and present threads
+void PipelineStop (void);
+
+// number of buffer swaps the FPGA has made since reset, wraps at 16 bits, for pacing
+// returns zero on bitstreams without the swap counter
+uint16_t PipelineGetSwapCount (void);
+
+// upload gLevels immediately from the calling thread, only while the pipeline is stopped
+void WriteLevels (void);
+
+#endif
@@ -0,0 +1,87 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+
+#ifndef __power_h_
+#define __power_h_
+
+// Supply current estimate and limit for every uploaded frame.
+//
+// A channel at level n is driven for n / 15 of each refresh, and the dimming register cuts
+// that to level / 0x100, so a panel draws in proportion to the sum of its 4-bit channel
+// levels times the dimming level. Sums are taken per panel with SIMD byte adds, SSE2 on x86
+// or NEON on the BeagleBone, and scaled to milliamps against POWER_PANEL_FULL_MA.
+// A panel over its budget has its levels scaled down to fit it, rounding down so the
+// estimate never lands above the budget. Then if all panels together are still over the
+// total budget, either the dimming register is brought down to fit when the bitstream has
+// one, or every panel's levels are scaled by the same factor, with a mA per panel to spare
+// for the panels' estimates rounding up, so the total never lands above its budget either.
+// The estimates before and after limiting go to the stats gauges, and limited frames are
+// counted.
+
+// estimated draw of one panel showing full white at full dimming level, about what a
+// 32x32 1/16 scan panel takes from its 5V supply
+#define POWER_PANEL_FULL_MA 4000
+
+class PowerLimit
+{
+    public:
+
+        // constructor
+        PowerLimit (void);
+
+        // destructor
+        ~PowerLimit (void) { }
+
+        // budgets in mA, 0 = no limit, useLevel brings the dimming register down for the
+        // total budget instead of scaling levels, on FPGA_HAS_DIMMING boards only
+        void setBudget (int32_t panelMa, int32_t totalMa, bool useLevel);
+
+        // estimate the frame at *level, returns it or a copy scaled into the budgets and
+        // lowers *level when that is what brings the total down
+        const Frame *limit (const Frame *frame, uint16_t *level);
+
+        // estimated draw of the last frame before and after limiting in mA
+        int32_t getDemand (void) {
+            return m_demand;
+        }
+        int32_t getPower (void) {
+            return m_power;
+        }
+
+        // estimated draw of the busiest panel after limiting in mA
+        int32_t getPanelPeak (void) {
+            return m_panelPeak;
+        }
+
+    private:
+
+        int32_t m_panelMa;
+        int32_t m_totalMa;
+        bool m_useLevel;
+        int32_t m_demand;
+        int32_t m_power;
+        int32_t m_panelPeak;
+        uint32_t m_sums[PANELS];
+        Frame m_limited;
+};
+
+#endif
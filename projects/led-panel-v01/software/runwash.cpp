@@ -36,47 +36,51 @@
 #include <math.h>
 
 #include "globals.h"
+#include "fpga.h"
+#include "frameloop.h"
+#include "pipeline.h"
 #include "pattern.h"
 #include "wash.h"
 
-// address register
-#define FPGA_PANEL_ADDR_REG 0x0010
-
-// data register
-#define FPGA_PANEL_DATA_REG 0x0012
-
-// buffer select register
-#define FPGA_PANEL_BUFFER_REG 0x0014
-
-// file descriptor for FPGA memory device
-int gFd = 0;
-
-// FPGA frame buffer select
-int32_t gBuffer = 0;
+// set by ctrl-c to shut down
+volatile sig_atomic_t gQuit = 0;
 
 // global levels to write to FPGA
 uint16_t gLevels[DISPLAY_HEIGHT][DISPLAY_WIDTH];
 
+// global linear frame, quantized to levels when running with -q
+uint16_t gLinear[3][DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+// global palette indices, mapped to levels when running with -q 3
+uint8_t gIndices[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+uint16_t gPalette[PALETTE_SIZE];
+int32_t gPaletteRotate = 0;
+
 // global object to create animated pattern
 Wash *gPattern = NULL;
 
 // prototypes
 void Quit (int sig);
 void BlankDisplay (void);
-void Write16 (uint16_t address, uint16_t data);
-void WriteLevels (void);
-void timer_handler (int signum);
+void RenderFrame (void);
 
 int main (int argc, char *argv[])
 {
-    struct sigaction sa;
-    struct itimerval timer;
+    FrameLoopConfig config;
+
+    // frame rate and scheduling from the command line
+    FrameLoopDefaults (&config);
+    if (!FrameLoopParseArgs (argc, argv, &config)) {
+        return -1;
+    }
 
     // trap ctrl-c to call quit function 
     signal (SIGINT, Quit);
 
     // open fpga memory device
-    gFd = open ("/dev/logibone_mem", O_RDWR | O_SYNC);
+    if (!FpgaOpen ()) {
+        return -1;
+    }
 
     // initialize levels to all off
     BlankDisplay ();
@@ -85,35 +89,38 @@ int main (int argc, char *argv[])
     gPattern = new Wash (DISPLAY_WIDTH, DISPLAY_HEIGHT,
 		1.0, 1.0, 0);
 
+    // draw linear light when the pipeline quantizes it, or palette indices it maps
+    gPattern->setLinear ((config.quantize == QUANTIZE_TEMPORAL) ||
+        (config.quantize == QUANTIZE_ORDERED));
+    if (!gPattern->setIndexed (config.quantize == QUANTIZE_PALETTE)) {
+        fprintf (stderr, "%s: this pattern can't draw palette indices\n", argv[0]);
+        delete gPattern;
+        FpgaClose ();
+        return -1;
+    }
+
     // reset to first frame
     gPattern->init ();
 
-    // install timer handler
-    memset (&sa, 0, sizeof (sa));
-    sa.sa_handler = &timer_handler;
-    sigaction (SIGALRM, &sa, NULL);
-
-    // configure the timer to expire after 20 msec
-    timer.it_value.tv_sec = 0;
-    timer.it_value.tv_usec = 20000;
-
-    // and every 20 msec after that.
-    timer.it_interval.tv_sec = 0;
-    timer.it_interval.tv_usec = 20000;
-
-    // start the timer
-    setitimer (ITIMER_REAL, &timer, NULL);
+    // start the render and present threads
+    if (!PipelineStart (RenderFrame, &config)) {
+        FpgaClose ();
+        return -1;
+    }
 
-    // wait forever
-    while (1) {
-        sleep (1);
+    // wait for ctrl-c
+    while (!gQuit) {
+        pause ();
     }
 
+    // stop the threads
+    PipelineStop ();
+
     // delete pattern object
     delete gPattern;
 
     // close fpga device
-    close (gFd);
+    FpgaClose ();
 
     return 0;
 }
@@ -121,11 +128,7 @@ int main (int argc, char *argv[])
 
 void Quit (int sig)
 {
-    if (gFd != 0) {
-        close (gFd);
-        gFd = 0;
-    }
-    exit (-1);
+    gQuit = 1;
 }
 
 
@@ -143,46 +146,8 @@ void BlankDisplay (void)
 }
 
 
-void Write16 (uint16_t address, uint16_t data)
+void RenderFrame (void)
 {
-    pwrite (gFd, &data, 2, address);
-}
-
-
-void WriteLevels (void)
-{
-    int row, col;
-
-    // ping pong between buffers
-    if (gBuffer == 0) {
-        Write16 (FPGA_PANEL_ADDR_REG, 0x0000);
-    } else {
-        Write16 (FPGA_PANEL_ADDR_REG, 0x0400);
-    }
-
-    // write data to selected buffer
-    for (row = 0; row < DISPLAY_HEIGHT; row++) {
-        for (col = 0; col < DISPLAY_WIDTH; col++) {
-            Write16 (FPGA_PANEL_DATA_REG, gLevels[row][col]);
-        }
-    }
-
-    // make that buffer active
-    if (gBuffer == 0) {
-        Write16 (FPGA_PANEL_BUFFER_REG, 0x0000);
-        gBuffer = 1;
-    } else {
-        Write16 (FPGA_PANEL_BUFFER_REG, 0x0001);
-        gBuffer = 0;
-    }
-}
-
-
-void timer_handler (int signum)
-{
-    // write levels to display
-    WriteLevels ();
-
     // calculate next frame in animation
     if (gPattern != NULL) {
         bool patternComplete = gPattern->next ();
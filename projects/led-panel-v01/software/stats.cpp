@@ -0,0 +1,306 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "fpga.h"
+#include "stats.h"
+
+typedef struct {
+    uint64_t buckets[STATS_BUCKETS];
+    uint64_t count;
+    uint64_t sum;               // usec
+    uint64_t max;               // usec
+} Histogram;
+
+static Histogram gHistograms[STATS_STAGES];
+static uint64_t gCounters[STATS_COUNTERS];
+static int64_t gGauges[STATS_GAUGES];
+
+// stage routed to the test pin
+static int32_t gTestPin = STATS_TEST_PIN_OFF;
+
+// socket server
+static int gServerFd = -1;
+static pthread_t gServerThread;
+static struct sockaddr_un gServerAddr;
+
+static const char *gStageNames[STATS_STAGES] = {
+    "render", "upload", "swap", "quantize"
+};
+
+static const char *gCounterNames[STATS_COUNTERS] = {
+    "frames_rendered", "frames_presented", "missed_deadlines",
+    "dropped_frames", "swap_timeouts", "bus_writes", "power_limited"
+};
+
+static const char *gGaugeNames[STATS_GAUGES] = {
+    "power_demand_ma", "power_ma", "panel_power_ma"
+};
+
+static void *ServerThread (void *arg);
+
+
+//---------------------------------------------------------------------------------------------
+// timing
+//
+
+static int64_t Now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+int64_t StatsBegin (StatsStage stage)
+{
+    if (gTestPin == stage) {
+        Write16 (FPGA_TEST_PIN_REG, 0x0001);
+    }
+
+    return Now ();
+}
+
+
+void StatsEnd (StatsStage stage, int64_t start)
+{
+    int64_t end = Now ();
+
+    if (gTestPin == stage) {
+        Write16 (FPGA_TEST_PIN_REG, 0x0000);
+    }
+
+    StatsRecord (stage, end - start);
+}
+
+
+void StatsRecord (StatsStage stage, int64_t nsec)
+{
+    Histogram *h = &gHistograms[stage];
+    uint64_t usec, max;
+    int32_t bucket;
+
+    usec = (nsec > 0) ? nsec / 1000 : 0;
+
+    // bucket n holds durations below 2^n usec
+    bucket = (usec == 0) ? 0 : 64 - __builtin_clzll (usec);
+    if (bucket >= STATS_BUCKETS) {
+        bucket = STATS_BUCKETS - 1;
+    }
+
+    __atomic_fetch_add (&h->buckets[bucket], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&h->sum, usec, __ATOMIC_RELAXED);
+
+    max = __atomic_load_n (&h->max, __ATOMIC_RELAXED);
+    while ((usec > max) && !__atomic_compare_exchange_n (&h->max, &max, usec, true,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// counters
+//
+
+void StatsCount (StatsCounter counter, uint32_t n)
+{
+    __atomic_fetch_add (&gCounters[counter], n, __ATOMIC_RELAXED);
+}
+
+
+uint64_t StatsGetCount (StatsCounter counter)
+{
+    return __atomic_load_n (&gCounters[counter], __ATOMIC_RELAXED);
+}
+
+
+void StatsSetTestPin (int32_t stage)
+{
+    gTestPin = stage;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// gauges
+//
+
+void StatsSetGauge (StatsGauge gauge, int64_t value)
+{
+    __atomic_store_n (&gGauges[gauge], value, __ATOMIC_RELAXED);
+}
+
+
+int64_t StatsGetGauge (StatsGauge gauge)
+{
+    return __atomic_load_n (&gGauges[gauge], __ATOMIC_RELAXED);
+}
+
+
+//---------------------------------------------------------------------------------------------
+// print everything in Prometheus text exposition format
+//
+
+void StatsPrint (FILE *fp)
+{
+    int32_t stage, bucket, counter, gauge;
+    uint64_t total;
+
+    for (stage = 0; stage < STATS_STAGES; stage++) {
+        Histogram *h = &gHistograms[stage];
+        const char *name = gStageNames[stage];
+
+        fprintf (fp, "# TYPE led_%s_usec histogram\n", name);
+        total = 0;
+        for (bucket = 0; bucket < STATS_BUCKETS; bucket++) {
+            total += __atomic_load_n (&h->buckets[bucket], __ATOMIC_RELAXED);
+            if (bucket < STATS_BUCKETS - 1) {
+                fprintf (fp, "led_%s_usec_bucket{le=\"%u\"} %llu\n", name,
+                    1u << bucket, (unsigned long long)total);
+            } else {
+                fprintf (fp, "led_%s_usec_bucket{le=\"+Inf\"} %llu\n", name,
+                    (unsigned long long)total);
+            }
+        }
+        fprintf (fp, "led_%s_usec_sum %llu\n", name,
+            (unsigned long long)__atomic_load_n (&h->sum, __ATOMIC_RELAXED));
+        fprintf (fp, "led_%s_usec_count %llu\n", name,
+            (unsigned long long)__atomic_load_n (&h->count, __ATOMIC_RELAXED));
+        fprintf (fp, "# TYPE led_%s_usec_max gauge\n", name);
+        fprintf (fp, "led_%s_usec_max %llu\n", name,
+            (unsigned long long)__atomic_load_n (&h->max, __ATOMIC_RELAXED));
+    }
+
+    for (counter = 0; counter < STATS_COUNTERS; counter++) {
+        fprintf (fp, "# TYPE led_%s_total counter\n", gCounterNames[counter]);
+        fprintf (fp, "led_%s_total %llu\n", gCounterNames[counter],
+            (unsigned long long)StatsGetCount ((StatsCounter)counter));
+    }
+
+    for (gauge = 0; gauge < STATS_GAUGES; gauge++) {
+        fprintf (fp, "# TYPE led_%s gauge\n", gGaugeNames[gauge]);
+        fprintf (fp, "led_%s %lld\n", gGaugeNames[gauge],
+            (long long)StatsGetGauge ((StatsGauge)gauge));
+    }
+}
+
+
+//---------------------------------------------------------------------------------------------
+// Unix socket server, each connection gets one dump and is closed
+//
+// scrape with: socat - UNIX-CONNECT:/path/to/socket
+//
+
+bool StatsStartServer (const char *path)
+{
+    struct stat st;
+
+    if (strlen (path) >= sizeof (gServerAddr.sun_path)) {
+        fprintf (stderr, "stats socket path too long: %s\n", path);
+        return false;
+    }
+
+    // replace a socket left by an earlier run, but never anything else at the path
+    if (lstat (path, &st) == 0) {
+        if (!S_ISSOCK (st.st_mode)) {
+            fprintf (stderr, "stats socket path is not a socket: %s\n", path);
+            return false;
+        }
+        unlink (path);
+    }
+
+    gServerFd = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (gServerFd < 0) {
+        perror ("stats socket");
+        return false;
+    }
+
+    memset (&gServerAddr, 0, sizeof (gServerAddr));
+    gServerAddr.sun_family = AF_UNIX;
+    strcpy (gServerAddr.sun_path, path);
+
+    if (bind (gServerFd, (struct sockaddr *)&gServerAddr, sizeof (gServerAddr)) != 0) {
+        perror ("stats socket");
+        close (gServerFd);
+        gServerFd = -1;
+        return false;
+    }
+
+    if ((listen (gServerFd, 4) != 0) ||
+            (pthread_create (&gServerThread, NULL, ServerThread, NULL) != 0)) {
+        perror ("stats socket");
+        close (gServerFd);
+        gServerFd = -1;
+        unlink (path);
+        return false;
+    }
+
+    return true;
+}
+
+
+void StatsStopServer (void)
+{
+    if (gServerFd < 0) {
+        return;
+    }
+
+    // wakes the server thread out of accept
+    shutdown (gServerFd, SHUT_RDWR);
+    pthread_join (gServerThread, NULL);
+    close (gServerFd);
+    gServerFd = -1;
+
+    // the socket file would otherwise stay behind until the next start replaced it
+    unlink (gServerAddr.sun_path);
+}
+
+
+static void *ServerThread (void *arg)
+{
+    int fd;
+    FILE *fp;
+
+    while ((fd = accept (gServerFd, NULL, NULL)) >= 0) {
+        fp = fdopen (fd, "w");
+        if (fp == NULL) {
+            close (fd);
+            continue;
+        }
+        StatsPrint (fp);
+        fclose (fp);
+    }
+
+    return NULL;
+}
@@ -0,0 +1,56 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#ifndef __tiles_h_
+#define __tiles_h_
+
+// Banded rendering on a work-stealing thread pool.
+//
+// Patterns that opt in draw each frame as bands of TILE_ROWS rows, see Pattern::renderBands.
+// TilesRun hands one pass over the bands to the calling thread and the workers TilesStart
+// made. Each thread starts on its own run of neighboring bands, taking them from the front,
+// and once that's empty steals from the back of the others' runs, so a worker the scheduler
+// holds up never holds up the frame. Band boundaries depend only on the frame height, never
+// on the thread count, so a pattern that combines its bands in band order draws the same
+// frame with any number of threads. With no workers every band runs on the calling thread,
+// which is all the single core BeagleBone needs.
+
+// rows per band, and most bands in a frame
+#define TILE_ROWS   8
+#define TILE_BANDS  ((DISPLAY_HEIGHT + TILE_ROWS - 1) / TILE_ROWS)
+
+// most threads, counting the caller
+#define TILES_MAX_THREADS 16
+
+// start threads - 1 workers to help the calling thread, returns false if they can't start
+bool TilesStart (int32_t threads);
+
+// stop and join the workers
+void TilesStop (void);
+
+// number of threads bands run on, counting the caller
+int32_t TilesGetThreads (void);
+
+// call work (arg, band) once for every band from 0 to bands - 1, across the workers and the
+// calling thread, and return when all are done. Only one thread at a time may run bands.
+void TilesRun (void (*work) (void *arg, int32_t band), void *arg, int32_t bands);
+
+#endif
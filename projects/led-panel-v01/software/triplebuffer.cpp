@@ -0,0 +1,69 @@
+//=============================================================================================
+// LED Matrix Animated Pattern Generator
+// Copyright 2014 by Glen Akins.
+// All rights reserved.
+//
+// Set editor width to 96 and tab stop to 4.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//=============================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "globals.h"
+#include "triplebuffer.h"
+
+
+//---------------------------------------------------------------------------------------------
+// constructor
+//
+
+TripleBuffer::TripleBuffer (void) :
+    m_back(0), m_front(1), m_middle(2)
+{
+    memset (m_frames, 0, sizeof (m_frames));
+    memset (m_linear, 0, sizeof (m_linear));
+    memset (m_indexed, 0, sizeof (m_indexed));
+}
+
+
+//---------------------------------------------------------------------------------------------
+// publish -- swap the finished back frame into the middle slot and mark it fresh
+//
+// release ordering makes the frame contents visible before the index that points at them
+//
+
+void TripleBuffer::publish (void)
+{
+    m_back = __atomic_exchange_n (&m_middle, m_back | FRESH, __ATOMIC_ACQ_REL) & ~FRESH;
+}
+
+
+//---------------------------------------------------------------------------------------------
+// acquire -- take the middle frame if it is fresh, leaving the old front frame as the spare
+//
+
+bool TripleBuffer::acquire (void)
+{
+    if ((__atomic_load_n (&m_middle, __ATOMIC_ACQUIRE) & FRESH) == 0) {
+        return false;
+    }
+
+    m_front = __atomic_exchange_n (&m_middle, m_front, __ATOMIC_ACQ_REL) & ~FRESH;
+
+    return true;
+}
@@ -98,17 +98,17 @@ bool Twinkle::next (void)
 				case 0: // off
 					if (r < (0.025*RAND_MAX)) {
 						m_twinklers[row][col].state = 1;
-						m_twinklers[row][col].hue = r % 96;
+						m_twinklers[row][col].hue = (r % HUE_STEPS) * HUE_ONE;
 						m_twinklers[row][col].percent = 10;
-						gLevels[row][col] = translateHueValue (m_twinklers[row][col].hue, 
-							(float)m_twinklers[row][col].percent/100.0);
+						storeHueValue (row, col, m_twinklers[row][col].hue, 
+							(m_twinklers[row][col].percent*VALUE_ONE + 50)/100);
 					}
 					break;
 
 				case 1: // ramp up
 						m_twinklers[row][col].percent += 10;
-						gLevels[row][col] = translateHueValue (m_twinklers[row][col].hue, 
-							(float)m_twinklers[row][col].percent/100.0);
+						storeHueValue (row, col, m_twinklers[row][col].hue, 
+							(m_twinklers[row][col].percent*VALUE_ONE + 50)/100);
 						if (m_twinklers[row][col].percent == 100) {
 							m_twinklers[row][col].state = 2;
 						}
@@ -120,8 +120,8 @@ bool Twinkle::next (void)
 					break;
 				case 3: // ramp down
 						m_twinklers[row][col].percent -= 10;
-						gLevels[row][col] = translateHueValue (m_twinklers[row][col].hue, 
-							(float)m_twinklers[row][col].percent/100.0);
+						storeHueValue (row, col, m_twinklers[row][col].hue, 
+							(m_twinklers[row][col].percent*VALUE_ONE + 50)/100);
 						if (m_twinklers[row][col].percent == 0) {
 							m_twinklers[row][col].state = 0;
 						}
@@ -24,7 +24,7 @@
 
 typedef struct {
 	uint8_t state;
-	uint8_t hue;
+	uint32_t hue;
 	uint8_t percent;
 } Twinkler;
 
@@ -41,7 +41,7 @@ Wash::Wash
     const int32_t width, const int32_t height
 ) : 
     Pattern (width, height),
-	m_step(1.0), m_scale(1.0)
+	m_step(1.0), m_scale(1.0), m_drawn(false)
 {
 }
 
@@ -52,7 +52,7 @@ Wash::Wash
 	const float step, const float scale, const float angle
 ) : 
     Pattern (width, height),
-	m_step(step), m_scale(scale), m_angle(angle)
+	m_step(step), m_scale(scale), m_angle(angle), m_drawn(false)
 {
 }
 
@@ -73,6 +73,7 @@ Wash::~Wash (void)
 void Wash::init (void)
 {
 	m_state = 0;
+	m_drawn = false;
 }
 
 
@@ -83,18 +84,42 @@ void Wash::init (void)
 bool Wash::next (void)
 {
 	int32_t row, col, hue;
+	uint32_t hues[DISPLAY_WIDTH];
 
 	float rads = m_angle*M_PI/180.0;
-	for (row = 0; row < m_height; row++) {
-		float x = row - ((m_width-1.0)/2.0);
-		for (col = 0; col < m_width; col++) {
-			float y = ((m_height-1.0)/2.0) - col;
-			float xp = x * cos (rads) - y * sin (rads);
-			// float yp = x * sin (rads) + y * cos (rads);
-			hue = m_state + m_scale * xp + 0.5;
-			while (hue < 0) hue += 96;
-			while (hue >= 96) hue -= 96;
-			gLevels[row][col] = translateHue (hue);
+
+	if (m_indexed) {
+		// draw each pixel's offset from m_state once, then only slide the palette
+		if (!m_drawn) {
+			for (row = 0; row < m_height; row++) {
+				float x = row - ((m_width-1.0)/2.0);
+				for (col = 0; col < m_width; col++) {
+					float y = ((m_height-1.0)/2.0) - col;
+					float xp = x * cos (rads) - y * sin (rads);
+					hue = floorf (m_scale * xp * HUE_ONE);
+					while (hue < 0) hue += HUE_WHEEL;
+					while (hue >= HUE_WHEEL) hue -= HUE_WHEEL;
+					gIndices[row][col] = ((hue + HUE_PER_INDEX / 2) / HUE_PER_INDEX) %
+						PALETTE_SIZE;
+				}
+			}
+			storeHuePalette ();
+			m_drawn = true;
+		}
+		rotateHuePalette (((m_state < 0) ? m_state + 96.0 : m_state) * HUE_ONE);
+	} else {
+		for (row = 0; row < m_height; row++) {
+			float x = row - ((m_width-1.0)/2.0);
+			for (col = 0; col < m_width; col++) {
+				float y = ((m_height-1.0)/2.0) - col;
+				float xp = x * cos (rads) - y * sin (rads);
+				// float yp = x * sin (rads) + y * cos (rads);
+				hue = floorf ((m_state + m_scale * xp) * HUE_ONE);
+				while (hue < 0) hue += HUE_WHEEL;
+				while (hue >= HUE_WHEEL) hue -= HUE_WHEEL;
+				hues[col] = hue;
+			}
+			storeHueRow (row, hues);
 		}
 	}
 
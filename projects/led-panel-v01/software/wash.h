@@ -59,6 +59,7 @@ class Wash : public Pattern
         }
         void setScale (const float scale) {
             m_scale = scale;
+            m_drawn = false;
         }
 
 		// get / set angle
@@ -67,6 +68,14 @@ class Wash : public Pattern
         }
         void setAngle (const float angle) {
             m_angle = angle;
+            m_drawn = false;
+        }
+
+    protected:
+
+        // the bands only slide around the color wheel, so they can be drawn once as indices
+        bool canIndex (void) {
+            return true;
         }
 
     private:
@@ -75,6 +84,7 @@ class Wash : public Pattern
         float m_scale;
 		float m_angle;
         float m_state;
+        bool m_drawn;
 };
 
 #endif
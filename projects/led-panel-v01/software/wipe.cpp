@@ -98,25 +98,25 @@ bool Wipe::next (void)
 
 					case 0: // left to right 
 						if (col == m_state) {
-							gLevels[row][col] = wipeColors[m_color];
+							storeLevel (row, col, wipeColors[m_color]);
 						}
 						break;
 
 					case 1: // right to left 
 						if (col == m_state) {
-							gLevels[row][m_width - 1 - col] = wipeColors[m_color];
+							storeLevel (row, m_width - 1 - col, wipeColors[m_color]);
 						}
 						break;
 
 					case 2: // top to bottom
 						if (row == m_state) {
-							gLevels[row][col] = wipeColors[m_color];
+							storeLevel (row, col, wipeColors[m_color]);
 						}
 						break;
 
 					case 3: // bottom to top
 						if (row == m_state) {
-							gLevels[m_height - 1 - row][col] = wipeColors[m_color];
+							storeLevel (m_height - 1 - row, col, wipeColors[m_color]);
 						}
 						break;
 				}